@@ -8,6 +8,7 @@
 #include <array>
 #include <iostream>
 #include <iterator>
+#include <memory_resource>
 #include <utility>
 #include <vector>
 
@@ -29,8 +30,27 @@ using int64 = signed long;
 template <typename T>
 using span = absl::Span<T>;
 
+template <typename T, typename Allocator = std::allocator<T>>
+using slice = std::vector<T, Allocator>;
+
+// memory_resource is the interface of the arena and pool below; strings and
+// pmr slices allocate from one when given it.
+using memory_resource = std::pmr::memory_resource;
+
+// arena hands out memory by bumping a pointer and frees it all at once when
+// it is released or destroyed.
+using arena = std::pmr::monotonic_buffer_resource;
+
+// pool keeps freed blocks in lists by size class for reuse. It is not
+// thread-safe.
+using pool = std::pmr::unsynchronized_pool_resource;
+
+namespace pmr {
+
 template <typename T>
-using slice = std::vector<T>;
+using slice = rflx::slice<T, std::pmr::polymorphic_allocator<T>>;
+
+}  // namespace pmr
 
 template <class K, class V>
 using map = absl::flat_hash_map<K, V>;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "types.hpp"
+#include "unicode/utf8/utf8.hpp"
 
 namespace rflx {
 namespace unicode {
@@ -27,6 +28,18 @@ slice<uint16> Encode(span<rune> const s);
 // by the UTF-16 encoding s.
 slice<rune> Decode(span<uint16> const s);
 
+// FromUTF8 writes into out the UTF-16 encoding of as much of the UTF-8 text
+// p as fits, without splitting a surrogate pair. Invalid bytes become U+FFFD,
+// as with utf8::DecodeRune. It returns the number of bytes of p consumed and
+// the number of units written. out never needs more units than p has bytes.
+constexpr pair<int64, int64> FromUTF8(span<uint8 const> p, span<uint16> out);
+
+// ToUTF8 writes into out the UTF-8 encoding of as much of the UTF-16 text s as
+// fits. Unpaired surrogates become U+FFFD, as with Decode. It returns the
+// number of units of s consumed and the number of bytes written. out never
+// needs more than three bytes per unit of s.
+constexpr pair<int64, int64> ToUTF8(span<uint16 const> s, span<uint8> out);
+
 }  // namespace utf16
 }  // namespace unicode
 }  // namespace rflx
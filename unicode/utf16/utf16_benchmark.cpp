@@ -0,0 +1,109 @@
+#include "benchmark/benchmark.h"
+#include "types.hpp"
+#include "unicode/utf16/utf16.hpp"
+
+namespace rflx {
+namespace unicode {
+namespace utf16 {
+
+namespace {
+
+void BenchmarkDecodeValidASCII(benchmark::State& state) {
+  // "hello world"
+  slice<uint16> data = {104, 101, 108, 108, 111, 32, 119, 111, 114, 108, 100};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Decode({data.data(), data.size()}));
+  }
+}
+
+BENCHMARK(BenchmarkDecodeValidASCII);
+
+void BenchmarkDecodeValidJapaneseChars(benchmark::State& state) {
+  // "日本語日本語日本語"
+  slice<uint16> data = {26085, 26412, 35486, 26085, 26412,
+                        35486, 26085, 26412, 35486};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Decode({data.data(), data.size()}));
+  }
+}
+
+BENCHMARK(BenchmarkDecodeValidJapaneseChars);
+
+void BenchmarkEncodeValidASCII(benchmark::State& state) {
+  slice<rune> data = {'h', 'e', 'l', 'l', 'o'};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Encode({data.data(), data.size()}));
+  }
+}
+
+BENCHMARK(BenchmarkEncodeValidASCII);
+
+void BenchmarkEncodeValidJapaneseChars(benchmark::State& state) {
+  slice<rune> data = {26085, 26412, 35486};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Encode({data.data(), data.size()}));
+  }
+}
+
+BENCHMARK(BenchmarkEncodeValidJapaneseChars);
+
+// LongInput repeats chunk until it is at least size bytes long.
+slice<uint8> LongInput(char const* chunk, uint64 size) {
+  uint64 const n = __builtin_strlen(chunk);
+  slice<uint8> b;
+  b.reserve(size + n);
+  while (b.size() < size) {
+    b.insert(b.end(), chunk, chunk + n);
+  }
+  return b;
+}
+
+void BenchmarkFromUTF8(benchmark::State& state, char const* chunk) {
+  slice<uint8> const b = LongInput(chunk, state.range(0));
+  slice<uint16> out(b.size());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        FromUTF8({b.data(), b.size()}, {out.data(), out.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK_CAPTURE(BenchmarkFromUTF8, ASCII, "0123456789")
+    ->Range(1 << 10, 1 << 20);
+BENCHMARK_CAPTURE(BenchmarkFromUTF8, Cyrillic, "брэдЛГТМ")
+    ->Range(1 << 10, 1 << 20);
+BENCHMARK_CAPTURE(BenchmarkFromUTF8, Japanese, "日本語日本語日本語日")
+    ->Range(1 << 10, 1 << 20);
+BENCHMARK_CAPTURE(BenchmarkFromUTF8, Emoji, "😀😃😄😁")
+    ->Range(1 << 10, 1 << 20);
+BENCHMARK_CAPTURE(BenchmarkFromUTF8, Mixed, "a 日本 😀 é б😃x語ГТ😄")
+    ->Range(1 << 10, 1 << 20);
+
+void BenchmarkToUTF8(benchmark::State& state, char const* chunk) {
+  slice<uint8> const b = LongInput(chunk, state.range(0));
+  slice<uint16> s(b.size());
+  s.resize(FromUTF8({b.data(), b.size()}, {s.data(), s.size()}).second);
+  slice<uint8> out(3 * s.size());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ToUTF8({s.data(), s.size()}, {out.data(), out.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * s.size() * sizeof(uint16));
+}
+
+BENCHMARK_CAPTURE(BenchmarkToUTF8, ASCII, "0123456789")
+    ->Range(1 << 10, 1 << 20);
+BENCHMARK_CAPTURE(BenchmarkToUTF8, Cyrillic, "брэдЛГТМ")
+    ->Range(1 << 10, 1 << 20);
+BENCHMARK_CAPTURE(BenchmarkToUTF8, Japanese, "日本語日本語日本語日")
+    ->Range(1 << 10, 1 << 20);
+BENCHMARK_CAPTURE(BenchmarkToUTF8, Emoji, "😀😃😄😁")
+    ->Range(1 << 10, 1 << 20);
+BENCHMARK_CAPTURE(BenchmarkToUTF8, Mixed, "a 日本 😀 é б😃x語ГТ😄")
+    ->Range(1 << 10, 1 << 20);
+
+}  // namespace
+
+}  // namespace utf16
+}  // namespace unicode
+}  // namespace rflx
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <type_traits>
+
 #include "unicode/utf16/utf16.hpp"
 
 namespace rflx {
@@ -13,7 +15,7 @@ constexpr rune kMaxRune = 0x10FFFF;
 // 0xdc00-0xe000 encodes the low 10 bits of a pair.
 // the value is those 20 bits plus 0x10000.
 constexpr rune kSurrogate1 = 0xD800;
-constexpr rune kSurrogate2 = 0xDFFF;
+constexpr rune kSurrogate2 = 0xDC00;
 constexpr rune kSurrogate3 = 0xE000;
 constexpr rune kSurrogateSelf = 0x10000;
 
@@ -24,7 +26,7 @@ constexpr bool IsSurrogate(rune r) {
 constexpr rune DecodeRune(rune r1, rune r2) {
   if (kSurrogate1 <= r1 && r1 < kSurrogate2 && kSurrogate2 <= r2 &&
       r2 < kSurrogate3) {
-    return ((r1 - kSurrogate1) << 10) | ((r2 - kSurrogate2) + kSurrogateSelf);
+    return (((r1 - kSurrogate1) << 10) | (r2 - kSurrogate2)) + kSurrogateSelf;
   }
   return kReplacementChar;
 }
@@ -34,7 +36,99 @@ constexpr pair<rune, rune> EncodeRune(rune r) {
     return {kReplacementChar, kReplacementChar};
   }
   r -= kSurrogateSelf;
-  return {kSurrogate1 + (r >> 10) & 0x3ff, kSurrogate2 + r & 0x3ff};
+  return {kSurrogate1 + ((r >> 10) & 0x3ff), kSurrogate2 + (r & 0x3ff)};
+}
+
+// FromUTF8 and ToUTF8 come in two flavours. The scalar ones below work one
+// rune at a time and are used for short inputs and in constant evaluation.
+// The simd ones, defined in utf16_simd.cpp, convert runs of ASCII and of
+// other BMP text in vector registers.
+
+namespace simd {
+
+constexpr uint64 kMinSize = 32;
+
+pair<int64, int64> FromUTF8(span<uint8 const> p, span<uint16> out);
+pair<int64, int64> ToUTF8(span<uint16 const> s, span<uint8> out);
+
+}  // namespace simd
+
+namespace scalar {
+
+// PutRune appends r to out at k, as one unit or as a surrogate pair. It
+// returns the number of units written, or 0 if they do not fit.
+constexpr int64 PutRune(span<uint16> out, uint64 k, rune r) {
+  if (r < kSurrogateSelf) {
+    if (k == out.size()) {
+      return 0;
+    }
+    out[k] = static_cast<uint16>(r);
+    return 1;
+  }
+  if (out.size() - k < 2) {
+    return 0;
+  }
+  auto const [r1, r2] = EncodeRune(r);
+  out[k] = static_cast<uint16>(r1);
+  out[k + 1] = static_cast<uint16>(r2);
+  return 2;
+}
+
+// NextRune returns the rune starting at s[i] and the number of units it
+// takes. Unpaired surrogates decode to U+FFFD.
+constexpr pair<rune, int64> NextRune(span<uint16 const> s, uint64 i) {
+  rune const r = s[i];
+  if (!IsSurrogate(r)) {
+    return {r, 1};
+  }
+  rune const decoded = DecodeRune(r, i + 1 < s.size() ? s[i + 1] : 0);
+  return {decoded, decoded == kReplacementChar ? 1 : 2};
+}
+
+constexpr pair<int64, int64> FromUTF8(span<uint8 const> p, span<uint16> out) {
+  uint64 i = 0;
+  uint64 k = 0;
+  while (i < p.size()) {
+    auto const [r, size] = utf8::DecodeRune(p.subspan(i));
+    int64 const units = PutRune(out, k, r);
+    if (units == 0) {
+      break;
+    }
+    i += size;
+    k += units;
+  }
+  return {i, k};
+}
+
+constexpr pair<int64, int64> ToUTF8(span<uint16 const> s, span<uint8> out) {
+  uint64 i = 0;
+  uint64 k = 0;
+  while (i < s.size()) {
+    auto const [r, units] = NextRune(s, i);
+    auto const [n, bytes] = utf8::EncodeRunes({&r, 1}, out.subspan(k));
+    if (n == 0) {
+      break;
+    }
+    i += units;
+    k += bytes;
+  }
+  return {i, k};
+}
+
+}  // namespace scalar
+
+constexpr pair<int64, int64> FromUTF8(span<uint8 const> p, span<uint16> out) {
+  if (std::is_constant_evaluated() || p.size() < simd::kMinSize) {
+    return scalar::FromUTF8(p, out);
+  }
+  return simd::FromUTF8(p, out);
+}
+
+constexpr pair<int64, int64> ToUTF8(span<uint16 const> s, span<uint8> out) {
+  if (std::is_constant_evaluated() || s.size() < simd::kMinSize) {
+    return scalar::ToUTF8(s, out);
+  }
+  return simd::ToUTF8(s, out);
 }
 
 }  // namespace utf16
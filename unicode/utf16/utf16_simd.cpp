@@ -0,0 +1,189 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+
+#include "unicode/utf16/utf16.hpp"
+#include "unicode/utf8/convert_sse42.hpp"
+#include "unicode/utf8/cpu.hpp"
+
+namespace rflx {
+namespace unicode {
+namespace utf16 {
+namespace simd {
+
+namespace {
+
+#if RFLX_CPU_X86
+
+// Each step looks at the next 16 bytes or units. Text that does not fit one
+// of the block shapes, here or in utf8/convert_sse42.hpp, is converted rune
+// by rune to the end of that window, so that a run of it does not redo the
+// block checks for every rune.
+
+RFLX_TARGET_SSE42 void StoreUnits(uint16* out, __m128i units) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out), units);
+}
+
+RFLX_TARGET_SSE42 pair<int64, int64> FromUTF8SSE42(span<uint8 const> p,
+                                                  span<uint16> out) {
+  uint64 const n = p.size();
+  uint64 const m = out.size();
+  uint64 i = 0;
+  uint64 k = 0;
+  while (i < n) {
+    // A window that starts with a four byte sequence fits no block shape.
+    if (n - i >= 16 && m - k >= 16 && p[i] < utf8::kt4) {
+      __m128i const input =
+          _mm_loadu_si128(reinterpret_cast<__m128i const*>(p.data() + i));
+      uint32 const high = _mm_movemask_epi8(input);
+      if ((high & 1) == 0) {
+        // Widen all 16 bytes; only the leading ASCII ones are kept.
+        StoreUnits(out.data() + k,
+                   _mm_unpacklo_epi8(input, _mm_setzero_si128()));
+        StoreUnits(out.data() + k + 8,
+                   _mm_unpackhi_epi8(input, _mm_setzero_si128()));
+        uint64 const ascii = high == 0 ? 16 : __builtin_ctz(high);
+        i += ascii;
+        k += ascii;
+        continue;
+      }
+      // The blocks that decode to runes below the surrogates are those of
+      // UTF-8 decoding, with each rune one unit.
+      __m128i units;
+      if (utf8::simd::DecodeTwoByteSSE42(input, &units)) {
+        StoreUnits(out.data() + k, units);
+        i += 16;
+        k += 8;
+        continue;
+      }
+      if (utf8::simd::DecodeThreeByteSSE42(input, &units)) {
+        StoreUnits(out.data() + k, _mm_packus_epi32(units, units));
+        i += 12;
+        k += 4;
+        continue;
+      }
+    }
+    // Stop early at an ASCII byte, which starts a block of its own.
+    uint64 const end = n - i > 16 ? i + 16 : n;
+    do {
+      auto const [r, size] = utf8::DecodeRune(p.subspan(i));
+      int64 const units = scalar::PutRune(out, k, r);
+      if (units == 0) {
+        return {i, k};
+      }
+      i += size;
+      k += units;
+    } while (i < end && p[i] >= utf8::kRuneSelf);
+  }
+  return {i, k};
+}
+
+// InRangeSSE42 reports for each unit whether lo <= u <= hi.
+RFLX_TARGET_SSE42 __m128i InRangeSSE42(__m128i units, uint16 lo, uint16 hi) {
+  return _mm_cmpeq_epi16(
+      _mm_min_epu16(_mm_max_epu16(units, _mm_set1_epi16(lo)),
+                    _mm_set1_epi16(hi)),
+      units);
+}
+
+// ToTwoByteSSE42 converts 8 units into 16 bytes if they all take two.
+RFLX_TARGET_SSE42 bool ToTwoByteSSE42(__m128i units, uint8* out) {
+  if (_mm_movemask_epi8(InRangeSSE42(units, 0x80, 0x7FF)) != 0xFFFF) {
+    return false;
+  }
+  // Build lead | continuation << 8 in each lane.
+  __m128i const lead =
+      _mm_or_si128(_mm_srli_epi16(units, 6), _mm_set1_epi16(0xC0));
+  __m128i const cont = _mm_or_si128(
+      _mm_and_si128(units, _mm_set1_epi16(0x3F)), _mm_set1_epi16(0x80));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                   _mm_or_si128(lead, _mm_slli_epi16(cont, 8)));
+  return true;
+}
+
+RFLX_TARGET_SSE42 pair<int64, int64> ToUTF8SSE42(span<uint16 const> s,
+                                                span<uint8> out) {
+  uint64 const n = s.size();
+  uint64 const m = out.size();
+  uint64 i = 0;
+  uint64 k = 0;
+  while (i < n) {
+    // The first unit picks the one block shape the window can have; a
+    // window that starts with a surrogate has none.
+    if (n - i >= 16 && m - k >= 16 && !IsSurrogate(s[i])) {
+      __m128i const u0 =
+          _mm_loadu_si128(reinterpret_cast<__m128i const*>(s.data() + i));
+      if (s[i] < utf8::kRuneSelf) {
+        __m128i const u1 = _mm_loadu_si128(
+            reinterpret_cast<__m128i const*>(s.data() + i + 8));
+        // Narrow all 16 units, clamped to a byte so that larger units show
+        // up as bytes with the top bit set; only the leading ASCII ones are
+        // kept.
+        __m128i const ff = _mm_set1_epi16(0xFF);
+        __m128i const bytes =
+            _mm_packus_epi16(_mm_min_epu16(u0, ff), _mm_min_epu16(u1, ff));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out.data() + k), bytes);
+        uint32 const high = _mm_movemask_epi8(bytes);
+        uint64 const ascii = high == 0 ? 16 : __builtin_ctz(high);
+        i += ascii;
+        k += ascii;
+        continue;
+      }
+      // Units that take three bytes are runes that take three bytes.
+      if (s[i] <= 0x7FF) {
+        if (ToTwoByteSSE42(u0, out.data() + k)) {
+          i += 8;
+          k += 16;
+          continue;
+        }
+      } else if (utf8::simd::EncodeThreeByteSSE42(_mm_cvtepu16_epi32(u0),
+                                                  out.data() + k)) {
+        i += 4;
+        k += 12;
+        continue;
+      }
+    }
+    uint64 const end = n - i < 16 ? n : i + 16;
+    // Near the end of out, only the runes that fit are converted.
+    if (m - k < utf8::kUTFMax * (end - i)) {
+      auto const [units, bytes] = scalar::ToUTF8(s.subspan(i), out.subspan(k));
+      return {i + units, k + bytes};
+    }
+    while (i < end) {
+      auto const [r, units] = scalar::NextRune(s, i);
+      k += utf8::EncodeRune({out.data() + k, utf8::kUTFMax}, r);
+      i += units;
+    }
+  }
+  return {i, k};
+}
+
+#endif  // RFLX_CPU_X86
+
+}  // namespace
+
+pair<int64, int64> FromUTF8(span<uint8 const> p, span<uint16> out) {
+#if RFLX_CPU_X86
+  static bool const sse42 = cpu::HasSSE42();
+  if (sse42) {
+    return FromUTF8SSE42(p, out);
+  }
+#endif
+  return scalar::FromUTF8(p, out);
+}
+
+pair<int64, int64> ToUTF8(span<uint16 const> s, span<uint8> out) {
+#if RFLX_CPU_X86
+  static bool const sse42 = cpu::HasSSE42();
+  if (sse42) {
+    return ToUTF8SSE42(s, out);
+  }
+#endif
+  return scalar::ToUTF8(s, out);
+}
+
+}  // namespace simd
+}  // namespace utf16
+}  // namespace unicode
+}  // namespace rflx
@@ -1 +1,265 @@
-#include "unicode/utf16/utf16.hpp"
\ No newline at end of file
+#include "unicode/utf16/utf16.hpp"
+
+#include "gtest/gtest.h"
+#include "types.hpp"
+
+namespace rflx {
+namespace unicode {
+namespace utf16 {
+
+TEST(utf16, TestConstants) {
+  if (kMaxRune != utf8::kMaxRune) {
+    FAIL() << "utf16.maxRune is wrong: " << kMaxRune << " should be "
+           << utf8::kMaxRune;
+  }
+  if (kReplacementChar != utf8::kRuneError) {
+    FAIL() << "utf16.replacementChar is wrong: " << kReplacementChar
+           << " should be " << utf8::kRuneError;
+  }
+}
+
+struct EncodeTest {
+  slice<rune> in;
+  slice<uint16> out;
+};
+
+slice<EncodeTest> encodeTests = {
+    {{1, 2, 3, 4}, {1, 2, 3, 4}},
+    {{0xffff, 0x10000, 0x10001, 0x12345, 0x10ffff},
+     {0xffff, 0xd800, 0xdc00, 0xd800, 0xdc01, 0xd808, 0xdf45, 0xdbff,
+      0xdfff}},
+    {{'a', 'b', 0xd7ff, 0xd800, 0xdfff, 0xe000, 0x110000, ~rune{0}},
+     {'a', 'b', 0xd7ff, 0xfffd, 0xfffd, 0xe000, 0xfffd, 0xfffd}},
+};
+
+TEST(utf16, TestEncode) {
+  for (EncodeTest& tt : encodeTests) {
+    slice<uint16> const out = Encode({tt.in.data(), tt.in.size()});
+    if (out != tt.out) {
+      FAIL() << "Encode(" << ::testing::PrintToString(tt.in)
+             << ") = " << ::testing::PrintToString(out) << ", want "
+             << ::testing::PrintToString(tt.out);
+    }
+  }
+}
+
+TEST(utf16, TestEncodeRune) {
+  for (uint64 i = 0; i < encodeTests.size(); ++i) {
+    EncodeTest const& tt = encodeTests[i];
+    uint64 j = 0;
+    for (rune const r : tt.in) {
+      auto const [r1, r2] = EncodeRune(r);
+      if (r < 0x10000 || r > kMaxRune) {
+        ASSERT_LT(j, tt.out.size()) << "EncodeRune(" << r << ") = "
+                                    << "too few outputs for [" << i << "]";
+        if (r1 != kReplacementChar || r2 != kReplacementChar) {
+          FAIL() << "EncodeRune(" << r << ") = " << r1 << ", " << r2
+                 << "; want 0xfffd, 0xfffd";
+        }
+        ++j;
+        continue;
+      }
+      ASSERT_LT(j + 1, tt.out.size()) << "EncodeRune(" << r << ") = "
+                                      << "too few outputs for [" << i << "]";
+      if (r1 != tt.out[j] || r2 != tt.out[j + 1]) {
+        FAIL() << "EncodeRune(" << r << ") = " << r1 << ", " << r2
+               << "; want " << tt.out[j] << ", " << tt.out[j + 1];
+      }
+      rune const dec = DecodeRune(r1, r2);
+      if (dec != r) {
+        FAIL() << "DecodeRune(" << r1 << ", " << r2 << ") = " << dec
+               << "; want " << r;
+      }
+      j += 2;
+    }
+    if (j != tt.out.size()) {
+      FAIL() << "EncodeRune didn't generate enough output for [" << i << "]";
+    }
+  }
+}
+
+struct DecodeTest {
+  slice<uint16> in;
+  slice<rune> out;
+};
+
+slice<DecodeTest> decodeTests = {
+    {{1, 2, 3, 4}, {1, 2, 3, 4}},
+    {{0xffff, 0xd800, 0xdc00, 0xd800, 0xdc01, 0xd808, 0xdf45, 0xdbff, 0xdfff},
+     {0xffff, 0x10000, 0x10001, 0x12345, 0x10ffff}},
+    {{0xd800, 'a'}, {0xfffd, 'a'}},
+    {{0xdfff}, {0xfffd}},
+};
+
+TEST(utf16, TestDecode) {
+  for (DecodeTest& tt : decodeTests) {
+    slice<rune> const out = Decode({tt.in.data(), tt.in.size()});
+    if (out != tt.out) {
+      FAIL() << "Decode(" << ::testing::PrintToString(tt.in)
+             << ") = " << ::testing::PrintToString(out) << ", want "
+             << ::testing::PrintToString(tt.out);
+    }
+  }
+}
+
+struct DecodeRuneTest {
+  rune r1;
+  rune r2;
+  rune want;
+};
+
+DecodeRuneTest decodeRuneTests[] = {
+    {0xd800, 0xdc00, 0x10000},  {0xd800, 0xdc01, 0x10001},
+    {0xd808, 0xdf45, 0x12345},  {0xdbff, 0xdfff, 0x10ffff},
+    {0xd800, 'a', 0xfffd},  // illegal, replacement rune substituted
+};
+
+TEST(utf16, TestDecodeRune) {
+  for (uint64 i = 0; i < std::size(decodeRuneTests); ++i) {
+    DecodeRuneTest const& tt = decodeRuneTests[i];
+    rune const got = DecodeRune(tt.r1, tt.r2);
+    if (got != tt.want) {
+      FAIL() << i << ": DecodeRune(" << tt.r1 << ", " << tt.r2
+             << ") = " << got << "; want " << tt.want;
+    }
+  }
+}
+
+struct SurrogateTest {
+  char const* name;
+  rune r;
+  bool want;
+};
+
+SurrogateTest surrogateTests[] = {
+    // from https://en.wikipedia.org/wiki/UTF-16
+    {"0x7A", 0x7A, false},        // LATIN SMALL LETTER Z
+    {"0x6C34", 0x6C34, false},    // CJK UNIFIED IDEOGRAPH-6C34 (water)
+    {"0xFEFF", 0xFEFF, false},    // Byte Order Mark
+    {"0x10000", 0x10000, false},  // LINEAR B SYLLABLE B008 A (first
+                                  // non-BMP code point)
+    {"0x1D11E", 0x1D11E, false},  // MUSICAL SYMBOL G CLEF
+    {"0x10FFFD", 0x10FFFD, false},  // PRIVATE USE CHARACTER-10FFFD (last
+                                    // Unicode code point)
+
+    {"0xD7FF", 0xD7FF, false},  // surr1-1
+    {"0xD800", 0xD800, true},   // surr1
+    {"0xDC00", 0xDC00, true},   // surr2
+    {"0xE000", 0xE000, false},  // surr3
+    {"0xDFFF", 0xDFFF, true},   // surr3-1
+};
+
+TEST(utf16, TestIsSurrogate) {
+  for (SurrogateTest const& tt : surrogateTests) {
+    if (IsSurrogate(tt.r) != tt.want) {
+      FAIL() << "IsSurrogate(" << tt.name << ") = " << !tt.want
+             << "; want " << tt.want;
+    }
+  }
+}
+
+// TranscodeInput returns UTF-8 text with long runs of each width, mixed
+// text and invalid bytes.
+slice<uint8> TranscodeInput() {
+  char const* const chunks[] = {
+      "0123456789abcdef",
+      "брэдЛГТМ",
+      "日本語日本語日本語日",
+      "a𝄞b日c\xc3\xa9",
+      "😀😃😄😁",
+      "\xed\xa0\x80" "a\x80\xff" "b\xe2\x82" "c\xf0\x9f\x98",
+  };
+  slice<uint8> b;
+  for (char const* chunk : chunks) {
+    for (int32 i = 0; i < 8; ++i) {
+      b.insert(b.end(), chunk, chunk + __builtin_strlen(chunk));
+    }
+  }
+  for (char const* chunk : chunks) {
+    b.insert(b.end(), chunk, chunk + __builtin_strlen(chunk));
+  }
+  return b;
+}
+
+TEST(utf16, TestFromUTF8) {
+  slice<uint8> const b = TranscodeInput();
+  for (uint64 start = 0; start < 64; ++start) {
+    span<uint8 const> const p =
+        span<uint8 const>{b.data(), b.size()}.subspan(start);
+    slice<rune> runes;
+    for (span<uint8 const> q = p; !q.empty();) {
+      auto const [r, size] = utf8::DecodeRune(q);
+      runes.push_back(r);
+      q.remove_prefix(size);
+    }
+    slice<uint16> const want = Encode({runes.data(), runes.size()});
+    for (uint64 room : {p.size(), want.size() / 2, uint64{17}}) {
+      slice<uint16> out(room);
+      slice<uint16> scalar_out(room);
+      auto const got = FromUTF8(p, {out.data(), out.size()});
+      auto const want_counts =
+          scalar::FromUTF8(p, {scalar_out.data(), scalar_out.size()});
+      if (got != want_counts) {
+        FAIL() << "FromUTF8(b[" << start << ":], " << room << ") = "
+               << got.first << ", " << got.second << ", want "
+               << want_counts.first << ", " << want_counts.second;
+      }
+      if (room == p.size() && got.second != static_cast<int64>(want.size())) {
+        FAIL() << "FromUTF8(b[" << start << ":]) wrote " << got.second
+               << " units, want " << want.size();
+      }
+      if (!std::equal(out.begin(), out.begin() + got.second, want.begin())) {
+        FAIL() << "FromUTF8(b[" << start << ":], " << room
+               << ") wrote the wrong units";
+      }
+    }
+  }
+}
+
+TEST(utf16, TestToUTF8) {
+  slice<uint8> const b = TranscodeInput();
+  slice<uint16> s(b.size());
+  s.resize(FromUTF8({b.data(), b.size()}, {s.data(), s.size()}).second);
+  // Unpaired surrogates, including one at the very end.
+  for (uint16 const u : {0xdc00, 0xd800, 0xdbff}) {
+    s.insert(s.begin() + s.size() / 2, u);
+    s.push_back('x');
+    s.push_back(u);
+  }
+  for (uint64 start = 0; start < 64; ++start) {
+    span<uint16 const> const p =
+        span<uint16 const>{s.data(), s.size()}.subspan(start);
+    slice<uint16> in(p.begin(), p.end());
+    slice<uint8> want;
+    for (rune const r : Decode({in.data(), in.size()})) {
+      array<uint8, utf8::kUTFMax> buf;
+      int32 const n = utf8::EncodeRune({buf.data(), buf.size()}, r);
+      want.insert(want.end(), buf.data(), buf.data() + n);
+    }
+    for (uint64 room : {3 * p.size(), want.size() / 2, uint64{17}}) {
+      slice<uint8> out(room);
+      slice<uint8> scalar_out(room);
+      auto const got = ToUTF8(p, {out.data(), out.size()});
+      auto const want_counts =
+          scalar::ToUTF8(p, {scalar_out.data(), scalar_out.size()});
+      if (got != want_counts) {
+        FAIL() << "ToUTF8(s[" << start << ":], " << room << ") = "
+               << got.first << ", " << got.second << ", want "
+               << want_counts.first << ", " << want_counts.second;
+      }
+      if (room == 3 * p.size() &&
+          got.second != static_cast<int64>(want.size())) {
+        FAIL() << "ToUTF8(s[" << start << ":]) wrote " << got.second
+               << " bytes, want " << want.size();
+      }
+      if (!std::equal(out.begin(), out.begin() + got.second, want.begin())) {
+        FAIL() << "ToUTF8(s[" << start << ":], " << room
+               << ") wrote the wrong bytes";
+      }
+    }
+  }
+}
+
+}  // namespace utf16
+}  // namespace unicode
+}  // namespace rflx
@@ -0,0 +1,76 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+#pragma once
+
+#include "types.hpp"
+#include "unicode/utf8/strings.hpp"
+#include "unicode/utf8/utf8.hpp"
+
+namespace rflx {
+
+// string_builder builds a string by appending to a buffer that doubles in
+// size when it fills up, so appending n bytes in pieces costs O(n).
+//
+//   string_builder b;
+//   b.Append(name);
+//   b.WriteRune(0x2192);
+//   string s = b.Finish();
+class string_builder {
+ public:
+  static constexpr uint64 kMinCapacity = 64;
+
+  constexpr string_builder() = default;
+  // The buffer and the strings finished from it are allocated from resource,
+  // which must outlive them.
+  explicit constexpr string_builder(memory_resource* resource);
+
+  string_builder(string_builder const&) = delete;
+  string_builder& operator=(string_builder const&) = delete;
+
+  constexpr string_builder(string_builder&& o) noexcept;
+  constexpr string_builder& operator=(string_builder&& o) noexcept;
+
+  constexpr ~string_builder();
+
+  constexpr uint64 Size() const;
+  constexpr uint64 Capacity() const;
+
+  // View returns the bytes written so far. The next write may move them, but
+  // the view may be passed to that write: b.Append(b.View()) doubles b.
+  constexpr string_view View() const;
+
+  // Reserve makes room for at least capacity bytes in all.
+  constexpr void Reserve(uint64 capacity);
+
+  constexpr void Append(string_view s);
+
+  // WriteRune appends the UTF-8 encoding of r, encoding it in place. Like
+  // EncodeRune, it writes RuneError for an invalid rune.
+  constexpr void WriteRune(rune r);
+
+  // Finish returns the bytes written and empties the builder. A string too
+  // long to be stored inline takes over the buffer without copying it; a
+  // shorter one is copied, and the builder keeps its buffer for reuse.
+  constexpr string Finish();
+
+ private:
+  // Grow makes room for n more bytes and appends s, which may point into the
+  // old buffer, before freeing it.
+  constexpr void Grow(uint64 n, string_view s = {});
+  constexpr uint8 Tag() const;
+
+  uint8* data_ = nullptr;
+  uint64 size_ = 0;
+  uint64 capacity_ = 0;
+  memory_resource* resource_ = nullptr;
+};
+
+// Join returns the parts with sep between each pair of them. It adds up the
+// size of the result first and allocates it once.
+constexpr string Join(span<string_view const> parts, string_view sep);
+
+}  // namespace rflx
+
+#include "unicode/utf8/builder_impl.hpp"
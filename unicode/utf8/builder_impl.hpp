@@ -0,0 +1,146 @@
+#pragma once
+
+#include "unicode/utf8/builder.hpp"
+
+namespace rflx {
+
+constexpr string_builder::string_builder(memory_resource* resource)
+    : resource_{resource} {}
+
+constexpr string_builder::string_builder(string_builder&& o) noexcept
+    : data_{o.data_},
+      size_{o.size_},
+      capacity_{o.capacity_},
+      resource_{o.resource_} {
+  o.data_ = nullptr;
+  o.size_ = 0;
+  o.capacity_ = 0;
+}
+
+constexpr string_builder& string_builder::operator=(
+    string_builder&& o) noexcept {
+  if (&o != this) {
+    if (data_ != nullptr) {
+      string::Deallocate(data_, Tag());
+    }
+    data_ = o.data_;
+    size_ = o.size_;
+    capacity_ = o.capacity_;
+    resource_ = o.resource_;
+    o.data_ = nullptr;
+    o.size_ = 0;
+    o.capacity_ = 0;
+  }
+  return *this;
+}
+
+constexpr string_builder::~string_builder() {
+  if (data_ != nullptr) {
+    string::Deallocate(data_, Tag());
+  }
+}
+
+constexpr uint8 string_builder::Tag() const {
+  return resource_ == nullptr ? string::kHeapTag : string::kResourceTag;
+}
+
+constexpr uint64 string_builder::Size() const { return size_; }
+
+constexpr uint64 string_builder::Capacity() const { return capacity_; }
+
+constexpr string_view string_builder::View() const { return {data_, size_}; }
+
+constexpr void string_builder::Reserve(uint64 capacity) {
+  if (capacity > capacity_) {
+    Grow(capacity - size_);
+  }
+}
+
+constexpr void string_builder::Grow(uint64 n, string_view s) {
+  uint64 capacity = capacity_ * 2;
+  if (capacity < size_ + n) {
+    capacity = size_ + n;
+  }
+  if (capacity < kMinCapacity) {
+    capacity = kMinCapacity;
+  }
+  uint8* const data = string::Allocate(capacity, resource_);
+  if (size_ > 0) {
+    __builtin_memcpy(data, data_, size_);
+  }
+  if (s.Size() > 0) {
+    __builtin_memcpy(data + size_, s.Data(), s.Size());
+  }
+  if (data_ != nullptr) {
+    string::Deallocate(data_, Tag());
+  }
+  data_ = data;
+  size_ += s.Size();
+  capacity_ = capacity;
+}
+
+constexpr void string_builder::Append(string_view s) {
+  if (s.Size() > capacity_ - size_) {
+    Grow(s.Size(), s);
+    return;
+  }
+  if (s.Size() > 0) {
+    __builtin_memcpy(data_ + size_, s.Data(), s.Size());
+  }
+  size_ += s.Size();
+}
+
+constexpr void string_builder::WriteRune(rune r) {
+  if (capacity_ - size_ < unicode::utf8::kUTFMax) {
+    Grow(unicode::utf8::kUTFMax);
+  }
+  if (r < unicode::utf8::kRuneSelf) {
+    data_[size_++] = static_cast<uint8>(r);
+    return;
+  }
+  size_ += unicode::utf8::EncodeRune({data_ + size_, unicode::utf8::kUTFMax},
+                                     r);
+}
+
+constexpr string string_builder::Finish() {
+  string s;
+  if (size_ <= string::kInlineCapacity) {
+    uint8* const data = s.Init(size_);
+    if (size_ > 0) {
+      __builtin_memcpy(data, data_, size_);
+    }
+    size_ = 0;
+    return s;
+  }
+  data_[size_] = '\n';
+  s.heap_ = {Tag(), data_, size_};
+  data_ = nullptr;
+  size_ = 0;
+  capacity_ = 0;
+  return s;
+}
+
+constexpr string Join(span<string_view const> parts, string_view sep) {
+  if (parts.empty()) {
+    return {};
+  }
+  uint64 size = sep.Size() * (parts.size() - 1);
+  for (string_view const& part : parts) {
+    size += part.Size();
+  }
+  string s;
+  uint8* p = s.Init(size);
+  for (uint64 i = 0; i < parts.size(); ++i) {
+    if (i > 0 && sep.Size() > 0) {
+      __builtin_memcpy(p, sep.Data(), sep.Size());
+      p += sep.Size();
+    }
+    if (parts[i].Size() > 0) {
+      __builtin_memcpy(p, parts[i].Data(), parts[i].Size());
+      p += parts[i].Size();
+    }
+  }
+  return s;
+}
+
+}  // namespace rflx
@@ -0,0 +1,121 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+#pragma once
+
+// The two and three byte blocks of the SSE4.2 conversion kernels, shared by
+// utf8::simd::DecodeRunes and EncodeRunes and by utf16::FromUTF8 and ToUTF8.
+// Each block either converts a whole block of one shape or reports that the
+// block does not have that shape, leaving the caller to try another.
+
+#include "types.hpp"
+#include "unicode/utf8/cpu.hpp"
+#include "unicode/utf8/utf8.hpp"
+
+#if RFLX_CPU_X86
+
+namespace rflx {
+namespace unicode {
+namespace utf8 {
+namespace simd {
+
+alignas(16) inline constexpr uint8 kThreeByteLanes[16] = {
+    2, 1, 0, 0x80, 5, 4, 3, 0x80, 8, 7, 6, 0x80, 11, 10, 9, 0x80,
+};
+
+alignas(16) inline constexpr uint8 kThreeByteBytes[16] = {
+    0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 0x80, 0x80, 0x80, 0x80,
+};
+
+// DecodeTwoByteSSE42 decodes 16 bytes into 8 runes, one in each 16 bit lane
+// of *runes, if they are 8 valid two byte sequences.
+inline RFLX_TARGET_SSE42 bool DecodeTwoByteSSE42(__m128i input,
+                                                 __m128i* runes) {
+  __m128i const cont = _mm_cmplt_epi8(input, _mm_set1_epi8(-64));
+  __m128i const lead = _mm_and_si128(
+      _mm_cmpeq_epi8(_mm_max_epu8(input, _mm_set1_epi8(char(0xC2))), input),
+      _mm_cmpeq_epi8(_mm_min_epu8(input, _mm_set1_epi8(char(0xDF))), input));
+  if (_mm_movemask_epi8(cont) != 0xAAAA || _mm_movemask_epi8(lead) != 0x5555) {
+    return false;
+  }
+  // Each 16 bit lane holds a lead byte and its continuation byte.
+  *runes = _mm_or_si128(
+      _mm_slli_epi16(_mm_and_si128(input, _mm_set1_epi16(kmask2)), 6),
+      _mm_and_si128(_mm_srli_epi16(input, 8), _mm_set1_epi16(kmaskx)));
+  return true;
+}
+
+// DecodeThreeByteSSE42 decodes the first 12 of 16 bytes into 4 runes, one in
+// each 32 bit lane of *runes, if they are 4 valid three byte sequences.
+inline RFLX_TARGET_SSE42 bool DecodeThreeByteSSE42(__m128i input,
+                                                   __m128i* runes) {
+  __m128i const cont = _mm_cmplt_epi8(input, _mm_set1_epi8(-64));
+  if ((_mm_movemask_epi8(cont) & 0xFFF) != 0b110110110110) {
+    return false;
+  }
+  // Each 32 bit lane holds one sequence, lead byte highest. The continuation
+  // bytes are known to be in range, so the lanes are valid if they are in
+  // range as numbers and outside of the surrogate halves.
+  __m128i const lanes = _mm_shuffle_epi8(
+      input, _mm_load_si128(reinterpret_cast<__m128i const*>(kThreeByteLanes)));
+  __m128i const in_range =
+      _mm_and_si128(_mm_cmpgt_epi32(lanes, _mm_set1_epi32(0xE0A07F)),
+                    _mm_cmplt_epi32(lanes, _mm_set1_epi32(0xF00000)));
+  __m128i const surrogate =
+      _mm_and_si128(_mm_cmpgt_epi32(lanes, _mm_set1_epi32(0xED9FBF)),
+                    _mm_cmplt_epi32(lanes, _mm_set1_epi32(0xEE0000)));
+  if (_mm_movemask_epi8(_mm_andnot_si128(surrogate, in_range)) != 0xFFFF) {
+    return false;
+  }
+  __m128i const mask = _mm_set1_epi32(kmaskx);
+  *runes = _mm_or_si128(
+      _mm_or_si128(
+          _mm_and_si128(lanes, mask),
+          _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(lanes, 8), mask), 6)),
+      _mm_slli_epi32(
+          _mm_and_si128(_mm_srli_epi32(lanes, 16), _mm_set1_epi32(kmask3)),
+          12));
+  return true;
+}
+
+// InRangeSSE42 reports for each rune whether lo <= r <= hi.
+inline RFLX_TARGET_SSE42 __m128i InRangeSSE42(__m128i runes, rune lo,
+                                              rune hi) {
+  return _mm_cmpeq_epi32(
+      _mm_min_epu32(_mm_max_epu32(runes, _mm_set1_epi32(lo)),
+                    _mm_set1_epi32(hi)),
+      runes);
+}
+
+// EncodeThreeByteSSE42 encodes the 4 runes in the 32 bit lanes of r into 12
+// bytes if they all take three and none is a surrogate half. It stores 16
+// bytes.
+inline RFLX_TARGET_SSE42 bool EncodeThreeByteSSE42(__m128i r, uint8* out) {
+  __m128i const ok =
+      _mm_andnot_si128(InRangeSSE42(r, kSurrogateMin, kSurrogateMax),
+                       InRangeSSE42(r, krune2Max + 1, krune3Max));
+  if (_mm_movemask_epi8(ok) != 0xFFFF) {
+    return false;
+  }
+  __m128i const mask = _mm_set1_epi32(kmaskx);
+  __m128i const cont = _mm_set1_epi32(ktx);
+  __m128i const b0 = _mm_or_si128(_mm_srli_epi32(r, 12), _mm_set1_epi32(kt3));
+  __m128i const b1 =
+      _mm_or_si128(_mm_and_si128(_mm_srli_epi32(r, 6), mask), cont);
+  __m128i const b2 = _mm_or_si128(_mm_and_si128(r, mask), cont);
+  __m128i const lanes = _mm_or_si128(
+      b0, _mm_or_si128(_mm_slli_epi32(b1, 8), _mm_slli_epi32(b2, 16)));
+  _mm_storeu_si128(
+      reinterpret_cast<__m128i*>(out),
+      _mm_shuffle_epi8(lanes, _mm_load_si128(reinterpret_cast<__m128i const*>(
+                                  kThreeByteBytes))));
+  return true;
+}
+
+}  // namespace simd
+}  // namespace utf8
+}  // namespace unicode
+}  // namespace rflx
+
+#endif  // RFLX_CPU_X86
@@ -0,0 +1,45 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+#pragma once
+
+// Helpers for the vectorized kernels. The library is built for the baseline
+// instruction set; wider code paths are compiled per function with the target
+// attribute and selected at runtime with the predicates below.
+
+#if defined(__x86_64__)
+#define RFLX_CPU_X86 1
+#include <immintrin.h>
+#define RFLX_TARGET_SSE42 __attribute__((target("sse4.2,popcnt")))
+#define RFLX_TARGET_AVX2 __attribute__((target("avx2,bmi,bmi2,popcnt")))
+#else
+#define RFLX_CPU_X86 0
+#endif
+
+namespace rflx {
+namespace cpu {
+
+// HasSSE42 reports whether the running CPU supports SSE4.2 and POPCNT.
+inline bool HasSSE42() {
+#if RFLX_CPU_X86
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+#else
+  return false;
+#endif
+}
+
+// HasAVX2 reports whether the running CPU supports AVX2, BMI2 and POPCNT.
+inline bool HasAVX2() {
+#if RFLX_CPU_X86
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2") &&
+         __builtin_cpu_supports("popcnt");
+#else
+  return false;
+#endif
+}
+
+}  // namespace cpu
+}  // namespace rflx
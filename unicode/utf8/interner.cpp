@@ -0,0 +1,87 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+
+#include "unicode/utf8/interner.hpp"
+
+#include <mutex>
+
+namespace rflx {
+
+string_view interned::View() const {
+  if (data_ == nullptr) {
+    return {};
+  }
+  uint64 size;
+  __builtin_memcpy(&size, data_ - sizeof(size), sizeof(size));
+  return {data_, size};
+}
+
+interner::interner() : shards_{new shard[kShards]} {}
+
+std::string_view interner::Key(string_view s) {
+  return {reinterpret_cast<char const*>(s.Data()), s.Size()};
+}
+
+interner::shard& interner::ShardOf(std::string_view key) const {
+  // The tables hash the key again; the top bits pick the shard so that the
+  // two uses of the hash stay independent.
+  uint64 const h = absl::Hash<std::string_view>{}(key);
+  return shards_[(h >> 58) % kShards];
+}
+
+interned interner::Intern(string_view s) {
+  if (s.Empty()) {
+    return {};
+  }
+  std::string_view const key = Key(s);
+  shard& sh = ShardOf(key);
+  {
+    std::shared_lock<std::shared_mutex> lock{sh.mu};
+    if (auto const it = sh.table.find(key); it != sh.table.end()) {
+      return it->second;
+    }
+  }
+
+  std::unique_lock<std::shared_mutex> lock{sh.mu};
+  if (auto const it = sh.table.find(key); it != sh.table.end()) {
+    return it->second;
+  }
+  // The record is the size, the bytes and a terminator, as in string.
+  uint64 const size = s.Size();
+  uint8* const record = static_cast<uint8*>(
+      sh.bytes.allocate(sizeof(size) + size + 1, alignof(uint64)));
+  __builtin_memcpy(record, &size, sizeof(size));
+  uint8* const data = record + sizeof(size);
+  __builtin_memcpy(data, s.Data(), size);
+  data[size] = '\n';
+  interned const handle{data};
+  sh.table.emplace(
+      std::string_view{reinterpret_cast<char const*>(data), size}, handle);
+  return handle;
+}
+
+pair<interned, bool> interner::Find(string_view s) const {
+  if (s.Empty()) {
+    return {{}, true};
+  }
+  std::string_view const key = Key(s);
+  shard const& sh = ShardOf(key);
+  std::shared_lock<std::shared_mutex> lock{sh.mu};
+  if (auto const it = sh.table.find(key); it != sh.table.end()) {
+    return {it->second, true};
+  }
+  return {{}, false};
+}
+
+int64 interner::Size() const {
+  int64 n = 0;
+  for (uint64 i = 0; i < kShards; ++i) {
+    std::shared_lock<std::shared_mutex> lock{shards_[i].mu};
+    n += shards_[i].table.size();
+  }
+  return n;
+}
+
+}  // namespace rflx
@@ -0,0 +1,79 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+#pragma once
+
+#include <memory>
+#include <shared_mutex>
+#include <string_view>
+
+#include "types.hpp"
+#include "unicode/utf8/strings.hpp"
+
+namespace rflx {
+
+// interned is a handle to a string stored in an interner. Two handles from
+// the same interner are equal exactly when their strings are, so comparing
+// and hashing them costs the same as for a pointer. The default handle is the
+// empty string.
+class interned {
+ public:
+  constexpr interned() = default;
+
+  constexpr bool operator==(interned const& o) const = default;
+
+  // View returns the string, which lives as long as the interner.
+  string_view View() const;
+
+  template <typename H>
+  friend H AbslHashValue(H h, interned i) {
+    return H::combine(std::move(h), i.data_);
+  }
+
+ private:
+  friend class interner;
+  explicit constexpr interned(uint8 const* data) : data_{data} {}
+
+  // data_ points at the bytes, which follow their size.
+  uint8 const* data_ = nullptr;
+};
+
+// interner stores one copy of each distinct string it is given. It is safe
+// to use from many threads at once: the strings are spread over kShards
+// tables by hash, each with its own reader-writer lock, so lookups of strings
+// already interned only take shared locks. The bytes are kept in an
+// append-only arena per shard and are freed when the interner is destroyed.
+class interner {
+ public:
+  static constexpr uint64 kShards = 64;
+
+  interner();
+  interner(interner const&) = delete;
+  interner& operator=(interner const&) = delete;
+
+  // Intern returns the handle of s, storing a copy of s the first time.
+  interned Intern(string_view s);
+
+  // Find returns the handle of s and true if s has been interned, or the
+  // empty handle and false if not. The empty string is always interned.
+  pair<interned, bool> Find(string_view s) const;
+
+  // Size returns the number of distinct non-empty strings stored.
+  int64 Size() const;
+
+ private:
+  struct alignas(64) shard {
+    mutable std::shared_mutex mu;
+    map<std::string_view, interned> table;
+    arena bytes;
+  };
+
+  static std::string_view Key(string_view s);
+  shard& ShardOf(std::string_view key) const;
+
+  // The shards take a few kilobytes, so they are kept off the stack.
+  std::unique_ptr<shard[]> shards_;
+};
+
+}  // namespace rflx
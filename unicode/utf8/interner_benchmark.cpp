@@ -0,0 +1,71 @@
+#include <atomic>
+#include <cstdio>
+
+#include "benchmark/benchmark.h"
+#include "types.hpp"
+#include "unicode/utf8/interner.hpp"
+
+namespace rflx {
+
+namespace {
+
+constexpr int64 kLabels = 1 << 12;
+
+// Labels returns kLabels distinct label strings.
+slice<slice<uint8>> Labels() {
+  slice<slice<uint8>> labels(kLabels);
+  for (int64 i = 0; i < kLabels; ++i) {
+    char buf[32];
+    int32 const n = std::snprintf(buf, sizeof(buf), "service/label_%ld", i);
+    labels[i].assign(buf, buf + n);
+  }
+  return labels;
+}
+
+// BenchmarkInternHits interns labels that are already present, from as many
+// threads as the benchmark runs.
+void BenchmarkInternHits(benchmark::State& state) {
+  static slice<slice<uint8>> const labels = Labels();
+  static interner* const in = [] {
+    interner* const in = new interner;
+    for (slice<uint8> const& b : labels) {
+      in->Intern({b.data(), b.size()});
+    }
+    return in;
+  }();
+  // Each thread starts at a different label.
+  static std::atomic<uint64> start{0};
+  uint64 i = start.fetch_add(101);
+  for (auto _ : state) {
+    slice<uint8> const& b = labels[i++ % kLabels];
+    benchmark::DoNotOptimize(in->Intern({b.data(), b.size()}));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BenchmarkInternHits)->ThreadRange(1, 8)->UseRealTime();
+
+// BenchmarkInternEquality compares interned labels by handle.
+void BenchmarkInternEquality(benchmark::State& state) {
+  static slice<slice<uint8>> const labels = Labels();
+  interner in;
+  slice<interned> handles;
+  for (slice<uint8> const& b : labels) {
+    handles.push_back(in.Intern({b.data(), b.size()}));
+  }
+  interned const want = handles[kLabels / 2];
+  for (auto _ : state) {
+    int64 matches = 0;
+    for (interned const h : handles) {
+      matches += h == want;
+    }
+    benchmark::DoNotOptimize(matches);
+  }
+  state.SetItemsProcessed(state.iterations() * kLabels);
+}
+
+BENCHMARK(BenchmarkInternEquality);
+
+}  // namespace
+
+}  // namespace rflx
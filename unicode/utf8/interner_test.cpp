@@ -0,0 +1,106 @@
+#include "unicode/utf8/interner.hpp"
+
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "types.hpp"
+
+namespace rflx {
+
+// Label returns the text of label i.
+slice<uint8> Label(int64 i) {
+  slice<uint8> b;
+  for (char const c : "label/") {
+    if (c != '\0') {
+      b.push_back(c);
+    }
+  }
+  for (; i > 0; i /= 10) {
+    b.push_back('0' + i % 10);
+  }
+  return b;
+}
+
+bool Equal(string_view s, slice<uint8> const& want) {
+  return s.Size() == want.size() &&
+         std::equal(want.begin(), want.end(), s.Data());
+}
+
+TEST(interner, TestIntern) {
+  interner in;
+  slice<uint8> const a = Label(1);
+  slice<uint8> const b = Label(2);
+  interned const ha = in.Intern({a.data(), a.size()});
+  interned const hb = in.Intern({b.data(), b.size()});
+  slice<uint8> const a_copy = a;
+  interned const ha2 = in.Intern({a_copy.data(), a_copy.size()});
+  if (ha != ha2 || ha == hb) {
+    FAIL() << "handles of equal strings differ, or of different ones match";
+  }
+  if (!Equal(ha.View(), a) || !Equal(hb.View(), b) ||
+      ha.View().Data() == a.data() || ha.View().Data()[a.size()] != '\n') {
+    FAIL() << "views are " << ha.View() << " and " << hb.View();
+  }
+  if (in.Size() != 2) {
+    FAIL() << "Size() = " << in.Size() << ", want 2";
+  }
+
+  auto const [found, ok] = in.Find({a_copy.data(), a_copy.size()});
+  slice<uint8> const c = Label(3);
+  auto const [missing, missing_ok] = in.Find({c.data(), c.size()});
+  if (!ok || found != ha || missing_ok || missing != interned{}) {
+    FAIL() << "Find";
+  }
+
+  interned const empty = in.Intern({});
+  if (empty != interned{} || !empty.View().Empty() || !in.Find({}).second ||
+      in.Size() != 2) {
+    FAIL() << "empty string";
+  }
+
+  map<interned, int32> counts;
+  ++counts[ha];
+  ++counts[ha2];
+  if (counts.size() != 1 || counts[ha] != 2) {
+    FAIL() << "handles as map keys";
+  }
+}
+
+TEST(interner, TestInternConcurrent) {
+  constexpr int32 kThreads = 8;
+  // A prime, so that every thread's stride visits every label.
+  constexpr int64 kLabels = 4999;
+  interner in;
+  slice<slice<interned>> handles(kThreads, slice<interned>(kLabels));
+  slice<std::thread> workers;
+  for (int32 t = 0; t < kThreads; ++t) {
+    workers.emplace_back([&in, &handles, t] {
+      // Each thread goes through the labels in its own order.
+      for (int64 k = 0; k < kLabels; ++k) {
+        int64 const i = (k * (2 * t + 1) + t * 977) % kLabels;
+        slice<uint8> const b = Label(i);
+        handles[t][i] = in.Intern({b.data(), b.size()});
+      }
+    });
+  }
+  for (std::thread& w : workers) {
+    w.join();
+  }
+
+  if (in.Size() != kLabels) {
+    FAIL() << "Size() = " << in.Size() << ", want " << kLabels;
+  }
+  for (int64 i = 0; i < kLabels; ++i) {
+    for (int32 t = 1; t < kThreads; ++t) {
+      if (handles[t][i] != handles[0][i]) {
+        FAIL() << "threads 0 and " << t << " got different handles for "
+               << handles[0][i].View();
+      }
+    }
+    if (!Equal(handles[0][i].View(), Label(i))) {
+      FAIL() << "label " << i << " is " << handles[0][i].View();
+    }
+  }
+}
+
+}  // namespace rflx
@@ -0,0 +1,44 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+#pragma once
+
+#include "types.hpp"
+#include "unicode/utf8/strings.hpp"
+#include "unicode/utf8/utf8.hpp"
+
+namespace rflx {
+
+// checked_literal is a string literal that is checked to be valid UTF-8 when
+// the program is compiled; an invalid one does not compile. Its rune count,
+// whether it is all ASCII and its length in UTF-16 units are worked out at
+// the same time, so reading them costs nothing at run time.
+//
+//   constexpr checked_literal kGreeting = "こんにちは";
+//   static_assert(kGreeting.RuneCount() == 5);
+class checked_literal {
+ public:
+  template <uint64 N>
+  consteval checked_literal(char const (&s)[N]);
+
+  constexpr uint64 Size() const;
+  constexpr int64 RuneCount() const;
+  constexpr bool ASCII() const;
+  constexpr int64 UTF16Len() const;
+
+  // View cannot be used during constant evaluation, which does not allow the
+  // bytes of the literal to be reinterpreted.
+  string_view View() const;
+
+ private:
+  char const* data_;
+  uint64 size_;
+  int64 runes_ = 0;
+  int64 utf16_len_ = 0;
+  bool ascii_ = true;
+};
+
+}  // namespace rflx
+
+#include "unicode/utf8/literal_impl.hpp"
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "unicode/utf8/literal.hpp"
+
+namespace rflx {
+
+namespace unicode::utf8 {
+
+// InvalidLiteral is deliberately not constexpr, nor defined. checked_literal
+// calls it for a literal that is not valid UTF-8, which stops the compilation
+// with its name in the error.
+void InvalidLiteral();
+
+}  // namespace unicode::utf8
+
+template <uint64 N>
+consteval checked_literal::checked_literal(char const (&s)[N])
+    : data_{s}, size_{N - 1} {
+  // The bytes of a literal cannot be reinterpreted during constant
+  // evaluation, so check a copy.
+  array<uint8, N> b{};
+  for (uint64 i = 0; i < N; ++i) {
+    b[i] = static_cast<uint8>(s[i]);
+  }
+  span<uint8 const> const p{b.data(), size_};
+  if (!unicode::utf8::Valid(p)) {
+    unicode::utf8::InvalidLiteral();
+  }
+  for (uint64 i = 0; i < size_;) {
+    auto const [r, size] = unicode::utf8::DecodeRune(p.subspan(i));
+    ascii_ = ascii_ && r < unicode::utf8::kRuneSelf;
+    utf16_len_ += r < 0x10000 ? 1 : 2;
+    ++runes_;
+    i += size;
+  }
+}
+
+constexpr uint64 checked_literal::Size() const { return size_; }
+
+constexpr int64 checked_literal::RuneCount() const { return runes_; }
+
+constexpr bool checked_literal::ASCII() const { return ascii_; }
+
+constexpr int64 checked_literal::UTF16Len() const { return utf16_len_; }
+
+inline string_view checked_literal::View() const {
+  return {reinterpret_cast<uint8 const*>(data_), size_};
+}
+
+}  // namespace rflx
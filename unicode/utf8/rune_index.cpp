@@ -0,0 +1,189 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+
+#include "unicode/utf8/rune_index.hpp"
+
+#include "unicode/utf8/utf8.hpp"
+
+namespace rflx {
+namespace unicode {
+namespace utf8 {
+
+namespace {
+
+constexpr uint64 kASCIIMask = 0x8080808080808080;
+
+// LoadWord reads 8 bytes without alignment requirements.
+uint64 LoadWord(uint8 const* p) {
+  uint64 w;
+  __builtin_memcpy(&w, p, sizeof(w));
+  return w;
+}
+
+// Starts returns the number of bytes in w that are not continuation bytes.
+// In valid UTF-8 each of them starts a rune.
+int64 Starts(uint64 w) {
+  return 8 - __builtin_popcountll(w & ~(w << 1) & kASCIIMask);
+}
+
+bool IsContinuation(uint8 b) { return (b & 0xC0) == 0x80; }
+
+}  // namespace
+
+rune_index::rune_index(string_view s) : s_{s} {}
+
+void rune_index::Build() const {
+  built_ = true;
+  runes_ = RuneCountInString(s_);
+  uint64 const n = s_.Size();
+  if (static_cast<uint64>(runes_) == n) {
+    // Every rune is one byte wide; offsets and positions coincide.
+    return;
+  }
+
+  uint8 const* const p = s_.Data();
+  samples_.reserve(runes_ / kStride + 1);
+  valid_ = ValidString(s_);
+  int64 runes = 0;
+  uint64 i = 0;
+  if (valid_) {
+    // Count rune starts a word at a time, down to bytes for the words that
+    // hold a sampled rune.
+    while (i < n) {
+      int64 const into = runes % kStride;
+      if (n - i >= 8) {
+        int64 const k = Starts(LoadWord(p + i));
+        if (k == 0 || (into != 0 && into + k <= kStride)) {
+          i += 8;
+          runes += k;
+          continue;
+        }
+      }
+      for (uint64 const end = n - i >= 8 ? i + 8 : n; i < end; ++i) {
+        if (!IsContinuation(p[i])) {
+          if (runes % kStride == 0) {
+            samples_.push_back(i);
+          }
+          ++runes;
+        }
+      }
+    }
+  } else {
+    while (i < n) {
+      int64 const into = runes % kStride;
+      if (into == 0) {
+        samples_.push_back(i);
+      }
+      // Skip ASCII a word at a time, as long as no sample is passed.
+      if (into + 8 <= kStride && n - i >= 8 &&
+          (LoadWord(p + i) & kASCIIMask) == 0) {
+        i += 8;
+        runes += 8;
+        continue;
+      }
+      i += DecodeRune({p + i, n - i}).second;
+      ++runes;
+    }
+  }
+
+  blocks_.resize(n / kBlockSize + 1);
+  uint32 j = 0;
+  for (uint64 k = 0; k < blocks_.size(); ++k) {
+    int64 const start = k * kBlockSize;
+    while (j + 1 < samples_.size() && samples_[j + 1] <= start) {
+      ++j;
+    }
+    blocks_[k] = j;
+  }
+}
+
+int64 rune_index::RuneCount() const {
+  if (!built_) {
+    Build();
+  }
+  return runes_;
+}
+
+int64 rune_index::ByteOffset(int64 i) const {
+  if (i < 0 || i > RuneCount()) {
+    return -1;
+  }
+  if (samples_.empty() || i == runes_) {
+    return i == runes_ ? s_.Size() : i;
+  }
+  uint8 const* const p = s_.Data();
+  uint64 const n = s_.Size();
+  uint64 pos = samples_[i / kStride];
+  int64 left = i % kStride;
+  if (!valid_) {
+    for (; left > 0; --left) {
+      pos += DecodeRune({p + pos, n - pos}).second;
+    }
+    return pos;
+  }
+  // Skip whole words of runes before the one wanted, then find its start.
+  while (n - pos >= 8) {
+    int64 const k = Starts(LoadWord(p + pos));
+    if (k > left) {
+      break;
+    }
+    left -= k;
+    pos += 8;
+  }
+  for (;; ++pos) {
+    if (!IsContinuation(p[pos])) {
+      if (left == 0) {
+        return pos;
+      }
+      --left;
+    }
+  }
+}
+
+int64 rune_index::RuneOffset(int64 b) const {
+  uint64 const n = s_.Size();
+  if (b < 0 || static_cast<uint64>(b) > n) {
+    return -1;
+  }
+  if (!built_) {
+    Build();
+  }
+  if (samples_.empty() || static_cast<uint64>(b) == n) {
+    return b == static_cast<int64>(n) ? runes_ : b;
+  }
+
+  uint32 j = blocks_[b / kBlockSize];
+  while (j + 1 < samples_.size() && samples_[j + 1] <= b) {
+    ++j;
+  }
+  // Every byte that is not a continuation byte starts a rune, so backing up
+  // to one finds the start of the rune containing b, if b is inside one.
+  uint8 const* const p = s_.Data();
+  int64 start = b;
+  for (int64 k = b; k > samples_[j] && b - k < int64{kUTFMax} - 1;) {
+    --k;
+    if (RuneStart(p[k])) {
+      if (DecodeRune({p + k, n - k}).second > b - k) {
+        start = k;
+      }
+      break;
+    }
+  }
+  uint64 const scan = start - samples_[j];
+  return j * kStride + utf8::RuneCount({p + samples_[j], scan});
+}
+
+string_view rune_index::Substr(int64 pos, int64 count) const {
+  if (pos < 0 || count < 0 || pos > RuneCount() || count > runes_ - pos) {
+    return {};
+  }
+  int64 const begin = ByteOffset(pos);
+  int64 const end = ByteOffset(pos + count);
+  return {s_.Data() + begin, static_cast<uint64>(end - begin)};
+}
+
+}  // namespace utf8
+}  // namespace unicode
+}  // namespace rflx
@@ -0,0 +1,68 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+#pragma once
+
+#include "types.hpp"
+#include "unicode/utf8/strings.hpp"
+
+namespace rflx {
+namespace unicode {
+namespace utf8 {
+
+// rune_index converts between rune positions and byte offsets in a string
+// view. Runes are counted the way DecodeRune steps through the text, so each
+// invalid byte is one rune.
+//
+// The index is built on first use. It samples the byte offset of every
+// kStride-th rune and, for every kBlockSize bytes, the last sample at or
+// before the block; that costs a few percent of the text's size and bounds
+// every lookup to a short scan. Text in which every rune is one byte, such
+// as ASCII, needs no samples at all.
+//
+// Building mutates the index, so a rune_index must not be shared between
+// threads before its first use.
+class rune_index {
+ public:
+  static constexpr int64 kStride = 256;
+  static constexpr int64 kBlockSize = 512;
+
+  // The view must outlive the index.
+  explicit rune_index(string_view s);
+
+  // RuneCount returns the number of runes in the text.
+  int64 RuneCount() const;
+
+  // ByteOffset returns the byte offset of the rune at position i, or the size
+  // of the text if i is RuneCount(). It returns -1 if i is out of range.
+  int64 ByteOffset(int64 i) const;
+
+  // RuneOffset returns the position of the rune that contains the byte at
+  // offset b, or RuneCount() if b is the size of the text. It returns -1 if b
+  // is out of range.
+  int64 RuneOffset(int64 b) const;
+
+  // Substr returns the runes [pos, pos+count) of the text, or an empty view
+  // if they are out of range.
+  string_view Substr(int64 pos, int64 count) const;
+
+ private:
+  void Build() const;
+
+  string_view s_;
+  mutable bool built_ = false;
+  mutable int64 runes_ = 0;
+  // valid_ is set if the text is valid UTF-8, in which case every byte that
+  // is not a continuation byte starts a rune.
+  mutable bool valid_ = false;
+  // samples_[j] is the byte offset of rune j*kStride.
+  mutable slice<int64> samples_;
+  // blocks_[k] is the index of the last sample at or before byte
+  // k*kBlockSize.
+  mutable slice<uint32> blocks_;
+};
+
+}  // namespace utf8
+}  // namespace unicode
+}  // namespace rflx
@@ -0,0 +1,66 @@
+#include "benchmark/benchmark.h"
+#include "types.hpp"
+#include "unicode/utf8/rune_index.hpp"
+#include "unicode/utf8/utf8.hpp"
+
+namespace rflx {
+namespace unicode {
+namespace utf8 {
+
+namespace {
+
+// LongText repeats chunk until it is at least size bytes long.
+slice<uint8> LongText(char const* chunk, uint64 size) {
+  uint64 const n = __builtin_strlen(chunk);
+  slice<uint8> b;
+  b.reserve(size + n);
+  while (b.size() < size) {
+    b.insert(b.end(), chunk, chunk + n);
+  }
+  return b;
+}
+
+void BenchmarkRuneIndexBuild(benchmark::State& state, char const* chunk) {
+  slice<uint8> const b = LongText(chunk, state.range(0));
+  for (auto _ : state) {
+    rune_index const index{{b.data(), b.size()}};
+    benchmark::DoNotOptimize(index.RuneCount());
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK_CAPTURE(BenchmarkRuneIndexBuild, ASCII, "0123456789")
+    ->Range(1 << 10, 1 << 20);
+BENCHMARK_CAPTURE(BenchmarkRuneIndexBuild, Japanese, "日本語日本語日本語日")
+    ->Range(1 << 10, 1 << 20);
+
+void BenchmarkRuneIndexByteOffset(benchmark::State& state) {
+  slice<uint8> const b = LongText("日本語a日本語b日本語c", 1 << 20);
+  rune_index const index{{b.data(), b.size()}};
+  int64 const count = index.RuneCount();
+  int64 i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(index.ByteOffset(i));
+    i = (i + 7919) % count;
+  }
+}
+
+BENCHMARK(BenchmarkRuneIndexByteOffset);
+
+void BenchmarkRuneIndexRuneOffset(benchmark::State& state) {
+  slice<uint8> const b = LongText("日本語a日本語b日本語c", 1 << 20);
+  rune_index const index{{b.data(), b.size()}};
+  int64 k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(index.RuneOffset(k));
+    k = (k + 7919) % b.size();
+  }
+}
+
+BENCHMARK(BenchmarkRuneIndexRuneOffset);
+
+}  // namespace
+
+}  // namespace utf8
+}  // namespace unicode
+}  // namespace rflx
@@ -0,0 +1,93 @@
+#include "unicode/utf8/rune_index.hpp"
+
+#include "gtest/gtest.h"
+#include "types.hpp"
+#include "unicode/utf8/utf8.hpp"
+
+namespace rflx {
+namespace unicode {
+namespace utf8 {
+
+// Repeat returns s repeated n times.
+slice<uint8> Repeat(char const* s, int32 n) {
+  slice<uint8> b;
+  for (int32 i = 0; i < n; ++i) {
+    b.insert(b.end(), s, s + __builtin_strlen(s));
+  }
+  return b;
+}
+
+TEST(utf8, TestRuneIndex) {
+  slice<slice<uint8>> inputs = {
+      {},
+      Repeat("a", 1),
+      Repeat("abcdefg", 300),
+      Repeat("\x80\xff", 300),
+      Repeat("日本語", 300),
+      Repeat("a☺\xff" "b日\xC0\xAF" "c\xf0\x9f\x98\x80" "d\xe2\x82", 100),
+  };
+  slice<uint8> mixed = Repeat("0123456789", 100);
+  slice<uint8> const japanese = Repeat("日本語", 200);
+  mixed.insert(mixed.end(), japanese.begin(), japanese.end());
+  inputs.push_back(mixed);
+
+  for (slice<uint8> const& b : inputs) {
+    string_view const s{b.data(), b.size()};
+    // starts[i] is the byte offset of rune i; rune[k] the rune containing
+    // byte k.
+    slice<int64> starts;
+    slice<int64> rune;
+    for (uint64 i = 0; i < b.size();) {
+      int8 const size = DecodeRune({b.data() + i, b.size() - i}).second;
+      for (int8 k = 0; k < size; ++k) {
+        rune.push_back(starts.size());
+      }
+      starts.push_back(i);
+      i += size;
+    }
+    starts.push_back(b.size());
+    rune.push_back(starts.size() - 1);
+
+    rune_index const index{s};
+    int64 const count = starts.size() - 1;
+    if (index.RuneCount() != count) {
+      FAIL() << "rune_index(" << s << ").RuneCount() = " << index.RuneCount()
+             << ", want " << count;
+    }
+    for (int64 i = 0; i <= count; ++i) {
+      if (int64 const got = index.ByteOffset(i); got != starts[i]) {
+        FAIL() << "ByteOffset(" << i << ") = " << got << ", want "
+               << starts[i] << " in " << b.size() << " bytes";
+      }
+    }
+    for (uint64 k = 0; k <= b.size(); ++k) {
+      if (int64 const got = index.RuneOffset(k); got != rune[k]) {
+        FAIL() << "RuneOffset(" << k << ") = " << got << ", want " << rune[k]
+               << " in " << b.size() << " bytes";
+      }
+    }
+    for (int64 bad : {int64{-1}, count + 1}) {
+      if (index.ByteOffset(bad) != -1) {
+        FAIL() << "ByteOffset(" << bad << ") = " << index.ByteOffset(bad)
+               << ", want -1";
+      }
+    }
+    if (index.RuneOffset(b.size() + 1) != -1) {
+      FAIL() << "RuneOffset(" << b.size() + 1 << ") != -1";
+    }
+    if (count >= 3) {
+      string_view const sub = index.Substr(1, count - 2);
+      if (sub.Data() != b.data() + starts[1] ||
+          static_cast<int64>(sub.Size()) != starts[count - 1] - starts[1]) {
+        FAIL() << "Substr(1, " << count - 2 << ") = " << sub;
+      }
+    }
+    if (!index.Substr(count, 1).Empty()) {
+      FAIL() << "Substr(" << count << ", 1) is not empty";
+    }
+  }
+}
+
+}  // namespace utf8
+}  // namespace unicode
+}  // namespace rflx
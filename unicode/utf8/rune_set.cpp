@@ -0,0 +1,297 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+
+#include "unicode/utf8/rune_set.hpp"
+
+#include "unicode/utf8/cpu.hpp"
+#include "unicode/utf8/utf8.hpp"
+
+namespace rflx {
+
+namespace {
+
+constexpr uint64 kBlockSize = 32;
+
+// Slot returns the first slot to probe for r in a table of the given size.
+uint64 Slot(rune r, uint64 size) {
+  return (uint64{r} * 0x9E3779B97F4A7C15) >> 32 & (size - 1);
+}
+
+// CandidateFn returns the offset of the first byte of p[i:n], or the last of
+// p[0:i], that may start a member of the set with the given bitmap and
+// nibble tables, or n if there is none.
+using CandidateFn = uint64 (*)(uint8 const* p, uint64 n, uint64 i,
+                               uint64 const* bytes, uint8 const* nibbles);
+
+bool Has(uint64 const* bytes, uint8 b) { return bytes[b >> 6] >> (b & 63) & 1; }
+
+uint64 NextCandidateScalar(uint8 const* p, uint64 n, uint64 i,
+                           uint64 const* bytes, uint8 const*) {
+  for (; i < n; ++i) {
+    if (Has(bytes, p[i])) {
+      return i;
+    }
+  }
+  return n;
+}
+
+uint64 PrevCandidateScalar(uint8 const* p, uint64 n, uint64 i,
+                           uint64 const* bytes, uint8 const*) {
+  while (i > 0) {
+    --i;
+    if (Has(bytes, p[i])) {
+      return i;
+    }
+  }
+  return n;
+}
+
+#if RFLX_CPU_X86
+
+// The set is tested 32 bytes at a time with two lookups. The low nibble of
+// each byte selects the row of its half of the byte range from nibbles_, and
+// the high nibble selects the bit of the row; bytes with the bit set may
+// start a member. A byte from 0x80 up is kept only if the byte after it is
+// marked as the second byte of a member, looked up the same way.
+struct classifier_avx2 {
+  __m256i low_half;
+  __m256i high_half;
+  __m256i second;
+  __m256i bits;
+};
+
+RFLX_TARGET_AVX2 classifier_avx2 ClassifierAVX2(uint8 const* nibbles) {
+  __m128i const* const rows = reinterpret_cast<__m128i const*>(nibbles);
+  return {_mm256_broadcastsi128_si256(_mm_load_si128(rows)),
+          _mm256_broadcastsi128_si256(_mm_load_si128(rows + 1)),
+          _mm256_broadcastsi128_si256(_mm_load_si128(rows + 2)),
+          _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64,
+                           -128, 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16,
+                           32, 64, -128)};
+}
+
+// CandidatesAVX2 returns the mask of the candidates among p[0:32]; it reads
+// p[32] as well.
+RFLX_TARGET_AVX2 uint32 CandidatesAVX2(classifier_avx2 const& c,
+                                       uint8 const* p) {
+  __m256i const nibble = _mm256_set1_epi8(0x0F);
+  __m256i const x = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+  __m256i const y =
+      _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p + 1));
+  __m256i const x_low = _mm256_and_si256(x, nibble);
+  __m256i const x_bit = _mm256_shuffle_epi8(
+      c.bits, _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble));
+  __m256i const x_row =
+      _mm256_blendv_epi8(_mm256_shuffle_epi8(c.low_half, x_low),
+                         _mm256_shuffle_epi8(c.high_half, x_low), x);
+  __m256i const y_bit = _mm256_shuffle_epi8(
+      c.bits, _mm256_and_si256(_mm256_srli_epi16(y, 4), nibble));
+  __m256i const y_row =
+      _mm256_shuffle_epi8(c.second, _mm256_and_si256(y, nibble));
+  uint32 const first = _mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(_mm256_and_si256(x_row, x_bit), x_bit));
+  // The second byte of a member is a continuation byte, so y must have its
+  // high bit set as well.
+  uint32 const second =
+      _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(y_row, y_bit),
+                                             y_bit)) &
+      _mm256_movemask_epi8(y);
+  uint32 const ascii = ~_mm256_movemask_epi8(x);
+  return first & (ascii | second);
+}
+
+RFLX_TARGET_AVX2 uint64 NextCandidateAVX2(uint8 const* p, uint64 n, uint64 i,
+                                          uint64 const* bytes,
+                                          uint8 const* nibbles) {
+  classifier_avx2 const c = ClassifierAVX2(nibbles);
+  for (; i + kBlockSize < n; i += kBlockSize) {
+    uint32 const mask = CandidatesAVX2(c, p + i);
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return NextCandidateScalar(p, n, i, bytes, nibbles);
+}
+
+RFLX_TARGET_AVX2 uint64 PrevCandidateAVX2(uint8 const* p, uint64 n, uint64 i,
+                                          uint64 const* bytes,
+                                          uint8 const* nibbles) {
+  // The last byte has no byte after it for the vector test.
+  if (i == n && i > 0) {
+    --i;
+    if (Has(bytes, p[i])) {
+      return i;
+    }
+  }
+  classifier_avx2 const c = ClassifierAVX2(nibbles);
+  for (; i >= kBlockSize; i -= kBlockSize) {
+    uint32 const mask = CandidatesAVX2(c, p + i - kBlockSize);
+    if (mask != 0) {
+      return i - kBlockSize + 31 - __builtin_clz(mask);
+    }
+  }
+  return PrevCandidateScalar(p, n, i, bytes, nibbles);
+}
+
+#endif
+
+CandidateFn SelectNextCandidate() {
+#if RFLX_CPU_X86
+  if (cpu::HasAVX2()) {
+    return NextCandidateAVX2;
+  }
+#endif
+  return NextCandidateScalar;
+}
+
+CandidateFn SelectPrevCandidate() {
+#if RFLX_CPU_X86
+  if (cpu::HasAVX2()) {
+    return PrevCandidateAVX2;
+  }
+#endif
+  return PrevCandidateScalar;
+}
+
+}  // namespace
+
+rune_set::rune_set(string_view chars) {
+  uint8 const* const p = chars.Data();
+  uint64 const n = chars.Size();
+  for (uint64 i = 0; i < n;) {
+    auto const [r, size] = unicode::utf8::DecodeRune({p + i, n - i});
+    Add(r);
+    i += size;
+  }
+}
+
+void rune_set::AddByte(uint8 b) {
+  bytes_[b >> 6] |= uint64{1} << (b & 63);
+  nibbles_[b >> 7][b & 0x0F] |= static_cast<uint8>(1 << (b >> 4 & 7));
+}
+
+bool rune_set::HasByte(uint8 b) const { return Has(bytes_, b); }
+
+void rune_set::Add(rune r) {
+  if (!unicode::utf8::ValidRune(r)) {
+    return;
+  }
+  if (r < unicode::utf8::kRuneSelf) {
+    AddByte(static_cast<uint8>(r));
+    return;
+  }
+  if (Contains(r)) {
+    return;
+  }
+  if (2 * (size_ + 1) > table_.size()) {
+    Grow();
+  }
+  uint64 i = Slot(r, table_.size());
+  while (table_[i] != 0) {
+    i = (i + 1) & (table_.size() - 1);
+  }
+  table_[i] = r;
+  ++size_;
+  uint8 lead[unicode::utf8::kUTFMax];
+  unicode::utf8::EncodeRune({lead, unicode::utf8::kUTFMax}, r);
+  AddByte(lead[0]);
+  nibbles_[2][lead[1] & 0x0F] |= static_cast<uint8>(1 << (lead[1] >> 4 & 7));
+  if (r == unicode::utf8::kRuneError) {
+    error_ = true;
+    for (uint32 b = 0x80; b <= 0xFF; ++b) {
+      AddByte(static_cast<uint8>(b));
+    }
+  }
+}
+
+void rune_set::Grow() {
+  slice<rune> old(table_.empty() ? 8 : 2 * table_.size());
+  old.swap(table_);
+  for (rune const r : old) {
+    if (r == 0) {
+      continue;
+    }
+    uint64 i = Slot(r, table_.size());
+    while (table_[i] != 0) {
+      i = (i + 1) & (table_.size() - 1);
+    }
+    table_[i] = r;
+  }
+}
+
+bool rune_set::Contains(rune r) const {
+  if (r < unicode::utf8::kRuneSelf) {
+    return HasByte(static_cast<uint8>(r));
+  }
+  if (table_.empty()) {
+    return false;
+  }
+  for (uint64 i = Slot(r, table_.size()); table_[i] != 0;
+       i = (i + 1) & (table_.size() - 1)) {
+    if (table_[i] == r) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int64 rune_set::IndexIn(string_view s) const {
+  uint8 const* const p = s.Data();
+  uint64 const n = s.Size();
+  if (error_) {
+    for (uint64 i = 0; i < n;) {
+      auto const [r, size] = unicode::utf8::DecodeRune({p + i, n - i});
+      if (Contains(r)) {
+        return i;
+      }
+      i += size;
+    }
+    return -1;
+  }
+  // ASCII bytes and lead bytes are where DecodeRune, stepping through s,
+  // would start a rune, and only a valid rune can be a member. Continuation
+  // bytes are never candidates, so a lead byte that does not start a member
+  // is followed by the search for the next candidate.
+  static CandidateFn const next = SelectNextCandidate();
+  for (uint64 i = 0;; ++i) {
+    i = next(p, n, i, bytes_, nibbles_[0]);
+    if (i == n) {
+      return -1;
+    }
+    if (p[i] < unicode::utf8::kRuneSelf ||
+        Contains(unicode::utf8::DecodeRune({p + i, n - i}).first)) {
+      return i;
+    }
+  }
+}
+
+int64 rune_set::LastIndexIn(string_view s) const {
+  uint8 const* const p = s.Data();
+  uint64 const n = s.Size();
+  if (error_) {
+    for (uint64 i = n; i > 0;) {
+      auto const [r, size] = unicode::utf8::DecodeLastRune({p, i});
+      i -= size;
+      if (Contains(r)) {
+        return i;
+      }
+    }
+    return -1;
+  }
+  // As in IndexIn; a valid rune decodes the same from either direction.
+  static CandidateFn const prev = SelectPrevCandidate();
+  for (uint64 i = n;;) {
+    i = prev(p, n, i, bytes_, nibbles_[0]);
+    if (i == n) {
+      return -1;
+    }
+    if (p[i] < unicode::utf8::kRuneSelf ||
+        Contains(unicode::utf8::DecodeRune({p + i, n - i}).first)) {
+      return i;
+    }
+  }
+}
+
+}  // namespace rflx
@@ -0,0 +1,58 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+#pragma once
+
+#include "types.hpp"
+#include "unicode/utf8/strings.hpp"
+
+namespace rflx {
+
+// rune_set is a set of runes compiled for scanning text for any of them.
+// Scans look at the bytes that could start a member, 32 at a time where the
+// CPU allows, and decode only those, so text is not decoded rune by rune
+// unless RuneError is a member; then every invalid byte matches and each
+// rune has to be decoded to tell.
+class rune_set {
+ public:
+  rune_set() = default;
+  // The set holds the runes of chars, and RuneError if chars is not valid
+  // UTF-8.
+  explicit rune_set(string_view chars);
+
+  // Add adds r to the set. Runes that are not valid are not added, since no
+  // text decodes to them.
+  void Add(rune r);
+  bool Contains(rune r) const;
+
+  // IndexIn returns the offset of the first rune of s in the set, or -1.
+  int64 IndexIn(string_view s) const;
+  // LastIndexIn returns the offset of the last rune of s in the set, or -1.
+  int64 LastIndexIn(string_view s) const;
+
+ private:
+  // AddByte marks b as a byte that may start a member.
+  void AddByte(uint8 b);
+  bool HasByte(uint8 b) const;
+  // Grow doubles the hash table, or creates it.
+  void Grow();
+
+  // bytes_ has a bit for each byte that may start a member: the ASCII
+  // members, the lead bytes of the others, and every byte from 0x80 if
+  // RuneError is a member.
+  uint64 bytes_[4] = {};
+  // nibbles_ is bytes_ arranged for lookups by low nibble: bit h of
+  // nibbles_[k][l] is the bit of byte 0x80*k + 0x10*h + l. nibbles_[2] is
+  // laid out like nibbles_[1] and marks the second bytes of the members from
+  // 0x80 up, which the vector scans check as well.
+  alignas(16) uint8 nibbles_[3][16] = {};
+  // table_ is an open-addressed hash table of the members from 0x80 up, with
+  // 0 in empty slots. Its size is zero or a power of two at least twice
+  // size_.
+  slice<rune> table_;
+  uint64 size_ = 0;
+  bool error_ = false;
+};
+
+}  // namespace rflx
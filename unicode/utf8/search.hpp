@@ -0,0 +1,64 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+#pragma once
+
+#include "types.hpp"
+#include "unicode/utf8/rune_set.hpp"
+#include "unicode/utf8/strings.hpp"
+#include "unicode/utf8/utf8.hpp"
+
+namespace rflx {
+
+// The searches return byte offsets. A valid UTF-8 substr starts with a rune,
+// so in a valid s the offsets it is found at are rune boundaries.
+
+// IndexByte returns the offset of the first c in s, or -1 if there is none.
+constexpr int64 IndexByte(string_view s, uint8 c);
+
+// LastIndexByte returns the offset of the last c in s, or -1 if there is
+// none.
+constexpr int64 LastIndexByte(string_view s, uint8 c);
+
+// IndexRune returns the offset of the first instance of r in s, or -1 if
+// there is none. If r is RuneError, it returns the first instance of any
+// invalid UTF-8 byte sequence.
+constexpr int64 IndexRune(string_view s, rune r);
+
+// ContainsRune reports whether r is within s.
+constexpr bool ContainsRune(string_view s, rune r);
+
+// Index returns the offset of the first instance of substr in s, or -1 if
+// there is none. The empty string is found at 0.
+constexpr int64 Index(string_view s, string_view substr);
+
+// LastIndex returns the offset of the last instance of substr in s, or -1 if
+// there is none. The empty string is found at s.Size().
+constexpr int64 LastIndex(string_view s, string_view substr);
+
+// Contains reports whether substr is within s.
+constexpr bool Contains(string_view s, string_view substr);
+
+// Count returns the number of non-overlapping instances of substr in s. If
+// substr is empty, it returns 1 + the number of runes in s.
+constexpr int64 Count(string_view s, string_view substr);
+
+// IndexAny returns the offset of the first rune of s in chars, or -1 if
+// there is none. chars is compiled into a rune_set for each call; hold on to
+// a rune_set to search for the same runes again.
+inline int64 IndexAny(string_view s, string_view chars);
+inline int64 IndexAny(string_view s, rune_set const& chars);
+
+// LastIndexAny returns the offset of the last rune of s in chars, or -1 if
+// there is none.
+inline int64 LastIndexAny(string_view s, string_view chars);
+inline int64 LastIndexAny(string_view s, rune_set const& chars);
+
+// ContainsAny reports whether any rune of chars is within s.
+inline bool ContainsAny(string_view s, string_view chars);
+inline bool ContainsAny(string_view s, rune_set const& chars);
+
+}  // namespace rflx
+
+#include "unicode/utf8/search_impl.hpp"
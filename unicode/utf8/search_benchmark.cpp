@@ -0,0 +1,155 @@
+#include <algorithm>
+
+#include "benchmark/benchmark.h"
+#include "types.hpp"
+#include "unicode/utf8/search.hpp"
+
+namespace rflx {
+
+namespace {
+
+constexpr uint64 kBodySize = 64 << 10;
+
+// Body returns kBodySize bytes of text ending in the given keyword.
+slice<uint8> Body(char const* keyword) {
+  char const* const text = "the quick brown fox jumps over the lazy dog; ";
+  slice<uint8> b;
+  while (b.size() < kBodySize) {
+    b.insert(b.end(), text, text + __builtin_strlen(text));
+  }
+  b.resize(kBodySize - __builtin_strlen(keyword));
+  b.insert(b.end(), keyword, keyword + __builtin_strlen(keyword));
+  return b;
+}
+
+string_view View(char const* s) { return {(uint8 const*)s}; }
+
+// BenchmarkIndex looks for a keyword at the end of a request body.
+void BenchmarkIndex(benchmark::State& state) {
+  slice<uint8> const body = Body("password=");
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        Index({body.data(), body.size()}, View("password=")));
+  }
+  state.SetBytesProcessed(state.iterations() * body.size());
+}
+BENCHMARK(BenchmarkIndex);
+
+// BenchmarkIndexStdSearch is BenchmarkIndex with std::search.
+void BenchmarkIndexStdSearch(benchmark::State& state) {
+  slice<uint8> const body = Body("password=");
+  string_view const keyword = View("password=");
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        std::search(body.begin(), body.end(), keyword.Data(),
+                    keyword.Data() + keyword.Size()));
+  }
+  state.SetBytesProcessed(state.iterations() * body.size());
+}
+BENCHMARK(BenchmarkIndexStdSearch);
+
+// BenchmarkIndexHard looks for a long needle that matches everywhere at both
+// ends.
+void BenchmarkIndexHard(benchmark::State& state) {
+  slice<uint8> body(kBodySize, 'a');
+  slice<uint8> needle(256, 'a');
+  needle[needle.size() / 2] = 'b';
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Index({body.data(), body.size()},
+                                   {needle.data(), needle.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * body.size());
+}
+BENCHMARK(BenchmarkIndexHard);
+
+// BenchmarkLastIndex looks for a keyword at the start of a body.
+void BenchmarkLastIndex(benchmark::State& state) {
+  slice<uint8> body = Body("");
+  char const* const keyword = "password=";
+  std::copy(keyword, keyword + 9, body.begin());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        LastIndex({body.data(), body.size()}, View("password=")));
+  }
+  state.SetBytesProcessed(state.iterations() * body.size());
+}
+BENCHMARK(BenchmarkLastIndex);
+
+// BenchmarkCount counts the spaces in a body.
+void BenchmarkCount(benchmark::State& state) {
+  slice<uint8> const body = Body("");
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Count({body.data(), body.size()}, View(" ")));
+  }
+  state.SetBytesProcessed(state.iterations() * body.size());
+}
+BENCHMARK(BenchmarkCount);
+
+// Japanese returns kBodySize bytes of Japanese text ending in the given
+// rune.
+slice<uint8> Japanese(char const* last) {
+  char const* const text = "日本語の文章を一文字ずつ読み込みます";
+  slice<uint8> b;
+  while (b.size() < kBodySize) {
+    b.insert(b.end(), text, text + __builtin_strlen(text));
+  }
+  b.resize(kBodySize - kBodySize % 3 - __builtin_strlen(last));
+  b.insert(b.end(), last, last + __builtin_strlen(last));
+  return b;
+}
+
+// BenchmarkIndexAny looks for any of a set of delimiters in a body.
+void BenchmarkIndexAny(benchmark::State& state) {
+  slice<uint8> const body = Body("&");
+  rune_set const delimiters{View("&=\r\n")};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(IndexAny({body.data(), body.size()}, delimiters));
+  }
+  state.SetBytesProcessed(state.iterations() * body.size());
+}
+BENCHMARK(BenchmarkIndexAny);
+
+// BenchmarkIndexAnyDecoding is BenchmarkIndexAny decoding each rune.
+void BenchmarkIndexAnyDecoding(benchmark::State& state) {
+  slice<uint8> const body = Body("&");
+  rune_set const delimiters{View("&=\r\n")};
+  for (auto _ : state) {
+    string_view const s{body.data(), body.size()};
+    int64 found = -1;
+    for (auto it = s.begin(); it != s.end(); ++it) {
+      if (delimiters.Contains(*it)) {
+        found = it.Offset();
+        break;
+      }
+    }
+    benchmark::DoNotOptimize(found);
+  }
+  state.SetBytesProcessed(state.iterations() * body.size());
+}
+BENCHMARK(BenchmarkIndexAnyDecoding);
+
+// BenchmarkIndexAnyJapanese looks for Japanese punctuation in Japanese text.
+void BenchmarkIndexAnyJapanese(benchmark::State& state) {
+  slice<uint8> const body = Japanese("。");
+  rune_set const punctuation{View("、。「」")};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        IndexAny({body.data(), body.size()}, punctuation));
+  }
+  state.SetBytesProcessed(state.iterations() * body.size());
+}
+BENCHMARK(BenchmarkIndexAnyJapanese);
+
+// BenchmarkIndexRuneJapanese looks for a rune in Japanese text.
+void BenchmarkIndexRuneJapanese(benchmark::State& state) {
+  slice<uint8> const body = Japanese("。");
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(IndexRune({body.data(), body.size()}, 0x3002));
+  }
+  state.SetBytesProcessed(state.iterations() * body.size());
+}
+BENCHMARK(BenchmarkIndexRuneJapanese);
+
+}  // namespace
+
+}  // namespace rflx
@@ -0,0 +1,318 @@
+#pragma once
+
+#include <type_traits>
+
+#include "unicode/utf8/search.hpp"
+
+namespace rflx {
+
+namespace simd {
+
+// Inputs shorter than this are searched by the scalar loops.
+constexpr uint64 kMinSize = 32;
+
+// Index checks the positions where both the first and the last byte of
+// substr match, found 32 at a time in vector registers. A long substr that
+// keeps matching at both ends but not in between sends it to Rabin-Karp.
+int64 Index(string_view s, string_view substr);
+
+// LastIndex is Index run backwards.
+int64 LastIndex(string_view s, string_view substr);
+
+// LastIndexByte calls memrchr.
+int64 LastIndexByte(string_view s, uint8 c);
+
+// Count compares 32 bytes at a time for a single byte and calls Index for
+// anything longer.
+int64 Count(string_view s, string_view substr);
+
+}  // namespace simd
+
+namespace scalar {
+
+// kPrimeRK is the prime base of the Rabin-Karp hashes.
+constexpr uint32 kPrimeRK = 16777619;
+
+// HashRK returns the Rabin-Karp hash of s and kPrimeRK to the power of its
+// size, which takes the byte leaving a window of that size out of the hash.
+constexpr pair<uint32, uint32> HashRK(string_view s) {
+  uint32 hash = 0;
+  for (uint64 i = 0; i < s.Size(); ++i) {
+    hash = hash * kPrimeRK + s.Data()[i];
+  }
+  uint32 pow = 1;
+  uint32 sq = kPrimeRK;
+  for (uint64 i = s.Size(); i > 0; i >>= 1) {
+    if (i & 1) {
+      pow *= sq;
+    }
+    sq *= sq;
+  }
+  return {hash, pow};
+}
+
+// HashRKReverse is HashRK over the bytes of s in reverse order.
+constexpr pair<uint32, uint32> HashRKReverse(string_view s) {
+  uint32 hash = 0;
+  for (uint64 i = s.Size(); i > 0; --i) {
+    hash = hash * kPrimeRK + s.Data()[i - 1];
+  }
+  return {hash, HashRK(s).second};
+}
+
+constexpr bool Equal(uint8 const* a, uint8 const* b, uint64 n) {
+  for (uint64 i = 0; i < n; ++i) {
+    if (a[i] != b[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// IndexRabinKarp rolls a hash over each window of s the size of substr and
+// compares the bytes only where it matches the hash of substr, which bounds
+// the work by the size of s whatever the bytes are.
+constexpr int64 IndexRabinKarp(string_view s, string_view substr) {
+  uint64 const n = substr.Size();
+  if (n > s.Size()) {
+    return -1;
+  }
+  uint8 const* const p = s.Data();
+  auto const [want, pow] = HashRK(substr);
+  uint32 hash = 0;
+  for (uint64 i = 0; i < n; ++i) {
+    hash = hash * kPrimeRK + p[i];
+  }
+  if (hash == want && Equal(p, substr.Data(), n)) {
+    return 0;
+  }
+  for (uint64 i = n; i < s.Size(); ++i) {
+    hash = hash * kPrimeRK + p[i] - pow * p[i - n];
+    if (hash == want && Equal(p + i + 1 - n, substr.Data(), n)) {
+      return i + 1 - n;
+    }
+  }
+  return -1;
+}
+
+// LastIndexRabinKarp is IndexRabinKarp from the end of s.
+constexpr int64 LastIndexRabinKarp(string_view s, string_view substr) {
+  uint64 const n = substr.Size();
+  if (n > s.Size()) {
+    return -1;
+  }
+  uint8 const* const p = s.Data();
+  uint64 const last = s.Size() - n;
+  auto const [want, pow] = HashRKReverse(substr);
+  uint32 hash = 0;
+  for (uint64 i = s.Size(); i > last; --i) {
+    hash = hash * kPrimeRK + p[i - 1];
+  }
+  if (hash == want && Equal(p + last, substr.Data(), n)) {
+    return last;
+  }
+  for (uint64 i = last; i > 0; --i) {
+    hash = hash * kPrimeRK + p[i - 1] - pow * p[i - 1 + n];
+    if (hash == want && Equal(p + i - 1, substr.Data(), n)) {
+      return i - 1;
+    }
+  }
+  return -1;
+}
+
+// IndexByteMemchr calls memchr, which constant evaluation cannot.
+inline int64 IndexByteMemchr(string_view s, uint8 c) {
+  if (s.Empty()) {
+    return -1;
+  }
+  void const* const found = __builtin_memchr(s.Data(), c, s.Size());
+  return found == nullptr ? -1 : static_cast<uint8 const*>(found) - s.Data();
+}
+
+constexpr int64 IndexByte(string_view s, uint8 c) {
+  if (!std::is_constant_evaluated()) {
+    return IndexByteMemchr(s, c);
+  }
+  for (uint64 i = 0; i < s.Size(); ++i) {
+    if (s.Data()[i] == c) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+constexpr int64 LastIndexByte(string_view s, uint8 c) {
+  for (uint64 i = s.Size(); i > 0; --i) {
+    if (s.Data()[i - 1] == c) {
+      return i - 1;
+    }
+  }
+  return -1;
+}
+
+// Index finds the first byte of substr with IndexByte and compares the rest.
+// Once that has failed more than about once every 16 bytes, it hands the
+// rest of s to IndexRabinKarp.
+constexpr int64 Index(string_view s, string_view substr) {
+  uint64 const n = substr.Size();
+  if (n == 0) {
+    return 0;
+  }
+  if (n == 1) {
+    return scalar::IndexByte(s, substr.Data()[0]);
+  }
+  if (n > s.Size()) {
+    return -1;
+  }
+  uint8 const* const p = s.Data();
+  uint8 const first = substr.Data()[0];
+  uint64 const t = s.Size() - n + 1;
+  uint64 fails = 0;
+  for (uint64 i = 0; i < t;) {
+    if (p[i] != first) {
+      int64 const o = scalar::IndexByte({p + i + 1, t - i - 1}, first);
+      if (o < 0) {
+        return -1;
+      }
+      i += o + 1;
+    }
+    if (Equal(p + i + 1, substr.Data() + 1, n - 1)) {
+      return i;
+    }
+    ++i;
+    ++fails;
+    if (fails >= 4 + (i >> 4) && i < t) {
+      int64 const j = IndexRabinKarp(s.Substr(i), substr);
+      return j < 0 ? -1 : i + j;
+    }
+  }
+  return -1;
+}
+
+constexpr int64 LastIndex(string_view s, string_view substr) {
+  uint64 const n = substr.Size();
+  if (n == 0) {
+    return s.Size();
+  }
+  if (n == 1) {
+    return scalar::LastIndexByte(s, substr.Data()[0]);
+  }
+  return LastIndexRabinKarp(s, substr);
+}
+
+constexpr int64 Count(string_view s, string_view substr) {
+  uint64 const n = substr.Size();
+  if (n == 0) {
+    return unicode::utf8::RuneCountInString(s) + 1;
+  }
+  int64 count = 0;
+  uint64 i = 0;
+  while (true) {
+    int64 const j = scalar::Index(s.Substr(i), substr);
+    if (j < 0) {
+      return count;
+    }
+    ++count;
+    i += j + n;
+  }
+}
+
+}  // namespace scalar
+
+constexpr int64 IndexByte(string_view s, uint8 c) {
+  return scalar::IndexByte(s, c);
+}
+
+constexpr int64 LastIndexByte(string_view s, uint8 c) {
+  if (std::is_constant_evaluated() || s.Size() < simd::kMinSize) {
+    return scalar::LastIndexByte(s, c);
+  }
+  return simd::LastIndexByte(s, c);
+}
+
+// IndexRune encodes r and looks for its bytes with Index.
+constexpr int64 IndexRune(string_view s, rune r) {
+  if (r < unicode::utf8::kRuneSelf) {
+    return IndexByte(s, static_cast<uint8>(r));
+  }
+  if (r == unicode::utf8::kRuneError) {
+    for (uint64 i = 0; i < s.Size();) {
+      auto const [d, size] =
+          unicode::utf8::DecodeRuneInString(s.Substr(i));
+      if (d == unicode::utf8::kRuneError) {
+        return i;
+      }
+      i += size;
+    }
+    return -1;
+  }
+  if (!unicode::utf8::ValidRune(r)) {
+    return -1;
+  }
+  uint8 b[unicode::utf8::kUTFMax] = {};
+  int32 const n = unicode::utf8::EncodeRune({b, unicode::utf8::kUTFMax}, r);
+  return Index(s, {b, static_cast<uint64>(n)});
+}
+
+constexpr bool ContainsRune(string_view s, rune r) {
+  return IndexRune(s, r) >= 0;
+}
+
+constexpr int64 Index(string_view s, string_view substr) {
+  if (std::is_constant_evaluated() || s.Size() < simd::kMinSize) {
+    return scalar::Index(s, substr);
+  }
+  return simd::Index(s, substr);
+}
+
+constexpr int64 LastIndex(string_view s, string_view substr) {
+  if (std::is_constant_evaluated() || s.Size() < simd::kMinSize) {
+    return scalar::LastIndex(s, substr);
+  }
+  return simd::LastIndex(s, substr);
+}
+
+constexpr bool Contains(string_view s, string_view substr) {
+  return Index(s, substr) >= 0;
+}
+
+constexpr int64 Count(string_view s, string_view substr) {
+  if (std::is_constant_evaluated() || s.Size() < simd::kMinSize) {
+    return scalar::Count(s, substr);
+  }
+  return simd::Count(s, substr);
+}
+
+// A single byte is searched for as a rune, with bytes from 0x80 standing for
+// RuneError as they do in a rune_set.
+inline int64 IndexAny(string_view s, string_view chars) {
+  if (chars.Size() == 1) {
+    uint8 const c = chars.Data()[0];
+    return IndexRune(s, c < unicode::utf8::kRuneSelf
+                            ? c
+                            : unicode::utf8::kRuneError);
+  }
+  return rune_set{chars}.IndexIn(s);
+}
+
+inline int64 IndexAny(string_view s, rune_set const& chars) {
+  return chars.IndexIn(s);
+}
+
+inline int64 LastIndexAny(string_view s, string_view chars) {
+  return rune_set{chars}.LastIndexIn(s);
+}
+
+inline int64 LastIndexAny(string_view s, rune_set const& chars) {
+  return chars.LastIndexIn(s);
+}
+
+inline bool ContainsAny(string_view s, string_view chars) {
+  return IndexAny(s, chars) >= 0;
+}
+
+inline bool ContainsAny(string_view s, rune_set const& chars) {
+  return chars.IndexIn(s) >= 0;
+}
+
+}  // namespace rflx
@@ -0,0 +1,179 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+
+#include <cstring>
+
+#include "unicode/utf8/cpu.hpp"
+#include "unicode/utf8/search.hpp"
+
+namespace rflx {
+namespace simd {
+
+namespace {
+
+#if RFLX_CPU_X86
+
+constexpr uint64 kBlockSize = 32;
+
+// A substr longer than this falls back to Rabin-Karp when too many of the
+// positions matching at both ends differ in between; comparing shorter ones
+// costs no more than a step of the hash.
+constexpr uint64 kLongNeedle = 32;
+
+// CandidatesAVX2 returns the mask of the positions j in [0, 32) where
+// p[j] == first and p[j + last_offset] == last.
+RFLX_TARGET_AVX2 uint32 CandidatesAVX2(uint8 const* p, uint64 last_offset,
+                                       __m256i first, __m256i last) {
+  __m256i const a = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+  __m256i const b =
+      _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p + last_offset));
+  return _mm256_movemask_epi8(
+      _mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+}
+
+// IndexAVX2 requires 2 <= substr.Size() <= s.Size().
+RFLX_TARGET_AVX2 int64 IndexAVX2(string_view s, string_view substr) {
+  uint8 const* const p = s.Data();
+  uint8 const* const q = substr.Data();
+  uint64 const m = substr.Size();
+  __m256i const first = _mm256_set1_epi8(static_cast<char>(q[0]));
+  __m256i const last = _mm256_set1_epi8(static_cast<char>(q[m - 1]));
+  // t is the number of positions substr can start at.
+  uint64 const t = s.Size() - m + 1;
+  uint64 fails = 0;
+  uint64 i = 0;
+  for (; i + kBlockSize <= t; i += kBlockSize) {
+    uint32 mask = CandidatesAVX2(p + i, m - 1, first, last);
+    while (mask != 0) {
+      uint64 const j = i + __builtin_ctz(mask);
+      if (std::memcmp(p + j + 1, q + 1, m - 2) == 0) {
+        return j;
+      }
+      mask &= mask - 1;
+      ++fails;
+    }
+    if (m > kLongNeedle && fails >= 4 + (i >> 4)) {
+      uint64 const next = i + kBlockSize;
+      int64 const j = scalar::IndexRabinKarp(s.Substr(next), substr);
+      return j < 0 ? -1 : next + j;
+    }
+  }
+  if (i == t) {
+    return -1;
+  }
+  int64 const j = scalar::Index(s.Substr(i), substr);
+  return j < 0 ? -1 : i + j;
+}
+
+// LastIndexAVX2 requires 2 <= substr.Size() <= s.Size().
+RFLX_TARGET_AVX2 int64 LastIndexAVX2(string_view s, string_view substr) {
+  uint8 const* const p = s.Data();
+  uint8 const* const q = substr.Data();
+  uint64 const m = substr.Size();
+  __m256i const first = _mm256_set1_epi8(static_cast<char>(q[0]));
+  __m256i const last = _mm256_set1_epi8(static_cast<char>(q[m - 1]));
+  uint64 fails = 0;
+  // Positions from i up have been checked.
+  uint64 i = s.Size() - m + 1;
+  for (; i >= kBlockSize; i -= kBlockSize) {
+    uint64 const block = i - kBlockSize;
+    uint32 mask = CandidatesAVX2(p + block, m - 1, first, last);
+    while (mask != 0) {
+      uint32 const bit = 31 - __builtin_clz(mask);
+      uint64 const j = block + bit;
+      if (std::memcmp(p + j + 1, q + 1, m - 2) == 0) {
+        return j;
+      }
+      mask ^= uint32{1} << bit;
+      ++fails;
+    }
+    if (m > kLongNeedle && fails >= 4 + ((s.Size() - block) >> 4)) {
+      return scalar::LastIndexRabinKarp({p, block + m - 1}, substr);
+    }
+  }
+  if (i == 0) {
+    return -1;
+  }
+  return scalar::LastIndex({p, i + m - 1}, substr);
+}
+
+RFLX_TARGET_AVX2 int64 CountByteAVX2(string_view s, uint8 c) {
+  uint8 const* const p = s.Data();
+  uint64 const n = s.Size();
+  __m256i const v = _mm256_set1_epi8(static_cast<char>(c));
+  int64 count = 0;
+  uint64 i = 0;
+  for (; i + kBlockSize <= n; i += kBlockSize) {
+    __m256i const a =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p + i));
+    count += __builtin_popcount(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(a, v)));
+  }
+  for (; i < n; ++i) {
+    count += p[i] == c;
+  }
+  return count;
+}
+
+#endif
+
+}  // namespace
+
+int64 Index(string_view s, string_view substr) {
+#if RFLX_CPU_X86
+  static bool const avx2 = cpu::HasAVX2();
+  if (avx2 && substr.Size() >= 2 && substr.Size() <= s.Size()) {
+    return IndexAVX2(s, substr);
+  }
+#endif
+  return scalar::Index(s, substr);
+}
+
+int64 LastIndex(string_view s, string_view substr) {
+  if (substr.Size() == 1) {
+    return simd::LastIndexByte(s, substr.Data()[0]);
+  }
+#if RFLX_CPU_X86
+  static bool const avx2 = cpu::HasAVX2();
+  if (avx2 && substr.Size() >= 2 && substr.Size() <= s.Size()) {
+    return LastIndexAVX2(s, substr);
+  }
+#endif
+  return scalar::LastIndex(s, substr);
+}
+
+int64 LastIndexByte(string_view s, uint8 c) {
+  if (s.Empty()) {
+    return -1;
+  }
+  void const* const found = memrchr(s.Data(), c, s.Size());
+  return found == nullptr ? -1 : static_cast<uint8 const*>(found) - s.Data();
+}
+
+int64 Count(string_view s, string_view substr) {
+  uint64 const n = substr.Size();
+  if (n == 0) {
+    return unicode::utf8::RuneCountInString(s) + 1;
+  }
+#if RFLX_CPU_X86
+  static bool const avx2 = cpu::HasAVX2();
+  if (avx2 && n == 1) {
+    return CountByteAVX2(s, substr.Data()[0]);
+  }
+#endif
+  int64 count = 0;
+  uint64 i = 0;
+  while (true) {
+    int64 const j = simd::Index(s.Substr(i), substr);
+    if (j < 0) {
+      return count;
+    }
+    ++count;
+    i += j + n;
+  }
+}
+
+}  // namespace simd
+}  // namespace rflx
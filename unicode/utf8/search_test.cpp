@@ -0,0 +1,329 @@
+#include "unicode/utf8/search.hpp"
+
+#include <random>
+
+#include "gtest/gtest.h"
+#include "types.hpp"
+#include "unicode/utf8/utf8.hpp"
+
+namespace rflx {
+
+string_view View(char const* s) { return {(uint8 const*)s}; }
+
+struct index_test {
+  char const* s;
+  char const* substr;
+  int64 index;
+  int64 last_index;
+  int64 count;
+};
+
+index_test const kIndexTests[] = {
+    {"", "", 0, 0, 1},
+    {"", "a", -1, -1, 0},
+    {"", "foo", -1, -1, 0},
+    {"fo", "foo", -1, -1, 0},
+    {"foo", "", 0, 3, 4},
+    {"foo", "foo", 0, 0, 1},
+    {"oofofoofooo", "f", 2, 7, 3},
+    {"oofofoofooo", "foo", 4, 7, 2},
+    {"barfoobarfoo", "foo", 3, 9, 2},
+    {"foo", "o", 1, 2, 2},
+    {"abcABCabc", "A", 3, 3, 1},
+    {"aaaaa", "aa", 0, 3, 2},
+    {"jrzm6jjhorimglljrea4w3rlgosts0w2gia17hno2td4qd1jz", "jz", 47, 47, 1},
+    {"ekkuk5oft4eq0ocpacknhwouic1uua46unx12l37nioq9wbpnocqks6",
+     "ks6", 52, 52, 1},
+    {"999f2xmimunbuyew5vrkla9cpwhmxan8o98ec", "98ec", 33, 33, 1},
+    {"9lpt9r98i04k8bz6c6dsrthb96bhi", "96bhi", 24, 24, 1},
+    {"55u558eqfaod2r2gu42xxsu631xf0zobs5840vl", "5840vl", 33, 33, 1},
+    {"xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+     "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx",
+     "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxy", -1, -1, 0},
+    {"日本語の日本語", "日本", 0, 12, 2},
+    {"日本語の日本語", "本語の日", 3, 3, 1},
+    {"日本語の日本語", "語", 6, 18, 2},
+    {"日本語の日本語", "", 0, 21, 8},
+};
+
+TEST(search, TestIndex) {
+  for (index_test const& t : kIndexTests) {
+    string_view const s = View(t.s);
+    string_view const substr = View(t.substr);
+    if (Index(s, substr) != t.index || LastIndex(s, substr) != t.last_index ||
+        Count(s, substr) != t.count ||
+        Contains(s, substr) != (t.index >= 0)) {
+      FAIL() << "Index(" << s << ", " << substr << ") = " << Index(s, substr)
+             << ", LastIndex = " << LastIndex(s, substr)
+             << ", Count = " << Count(s, substr);
+    }
+    if (substr.Size() == 1 && (IndexByte(s, substr.Data()[0]) != t.index ||
+                               LastIndexByte(s, substr.Data()[0]) !=
+                                   t.last_index)) {
+      FAIL() << "IndexByte(" << s << ", " << substr << ")";
+    }
+  }
+}
+
+// The searches are usable during constant evaluation.
+constexpr uint8 kCheese[] = {'c', 'h', 'e', 'e', 's', 'e'};
+constexpr uint8 kSe[] = {'s', 'e'};
+static_assert(Index({kCheese, 6}, {kSe, 2}) == 4);
+static_assert(LastIndex({kCheese, 6}, {kCheese + 2, 1}) == 5);
+static_assert(Count({kCheese, 6}, {kCheese + 2, 1}) == 3);
+static_assert(Count({kCheese, 6}, {}) == 7);
+
+// NaiveIndex and NaiveLastIndex are the definitions of Index and LastIndex.
+int64 NaiveIndex(slice<uint8> const& s, slice<uint8> const& substr) {
+  for (uint64 i = 0; i + substr.size() <= s.size(); ++i) {
+    if (std::equal(substr.begin(), substr.end(), s.begin() + i)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int64 NaiveLastIndex(slice<uint8> const& s, slice<uint8> const& substr) {
+  for (uint64 i = s.size() + 1; i-- > substr.size();) {
+    if (std::equal(substr.begin(), substr.end(),
+                   s.begin() + i - substr.size())) {
+      return i - substr.size();
+    }
+  }
+  return -1;
+}
+
+int64 NaiveCount(slice<uint8> const& s, slice<uint8> const& substr) {
+  int64 count = 0;
+  for (uint64 i = 0; i + substr.size() <= s.size();) {
+    if (std::equal(substr.begin(), substr.end(), s.begin() + i)) {
+      ++count;
+      i += substr.size();
+    } else {
+      ++i;
+    }
+  }
+  return count;
+}
+
+TEST(search, TestIndexRandom) {
+  // Small alphabets make for many near matches, which exercise the checks
+  // behind the vector prefilter and the switch to Rabin-Karp.
+  std::mt19937_64 rng{1};
+  for (int32 iter = 0; iter < 20000; ++iter) {
+    uint8 const alphabet = 1 + rng() % 3;
+    slice<uint8> s(rng() % 300);
+    for (uint8& b : s) {
+      b = 'a' + rng() % alphabet;
+    }
+    slice<uint8> substr(1 + rng() % 70);
+    for (uint8& b : substr) {
+      b = 'a' + rng() % alphabet;
+    }
+    // Plant substr at a random place half of the time.
+    if (iter % 2 == 0 && substr.size() <= s.size()) {
+      uint64 const at = rng() % (s.size() - substr.size() + 1);
+      std::copy(substr.begin(), substr.end(), s.begin() + at);
+    }
+    string_view const sv{s.data(), s.size()};
+    string_view const subv{substr.data(), substr.size()};
+    if (Index(sv, subv) != NaiveIndex(s, substr) ||
+        LastIndex(sv, subv) != NaiveLastIndex(s, substr) ||
+        Count(sv, subv) != NaiveCount(s, substr)) {
+      FAIL() << "Index(" << sv << ", " << subv << ") = " << Index(sv, subv)
+             << ", want " << NaiveIndex(s, substr) << "; LastIndex = "
+             << LastIndex(sv, subv) << ", want "
+             << NaiveLastIndex(s, substr) << "; Count = " << Count(sv, subv)
+             << ", want " << NaiveCount(s, substr);
+    }
+  }
+}
+
+TEST(search, TestIndexScalar) {
+  std::mt19937_64 rng{2};
+  for (int32 iter = 0; iter < 2000; ++iter) {
+    slice<uint8> s(rng() % 200);
+    for (uint8& b : s) {
+      b = 'a' + rng() % 2;
+    }
+    slice<uint8> substr(1 + rng() % 12);
+    for (uint8& b : substr) {
+      b = 'a' + rng() % 2;
+    }
+    string_view const sv{s.data(), s.size()};
+    string_view const subv{substr.data(), substr.size()};
+    if (scalar::IndexRabinKarp(sv, subv) != NaiveIndex(s, substr) ||
+        scalar::LastIndexRabinKarp(sv, subv) != NaiveLastIndex(s, substr)) {
+      FAIL() << "IndexRabinKarp(" << sv << ", " << subv << ")";
+    }
+    if (scalar::Index(sv, subv) != NaiveIndex(s, substr) ||
+        scalar::LastIndex(sv, subv) != NaiveLastIndex(s, substr) ||
+        scalar::Count(sv, subv) != NaiveCount(s, substr)) {
+      FAIL() << "scalar::Index(" << sv << ", " << subv << ")";
+    }
+  }
+}
+
+struct index_rune_test {
+  char const* s;
+  rune r;
+  int64 index;
+};
+
+index_rune_test const kIndexRuneTests[] = {
+    {"", 'a', -1},
+    {"", 0x263A, -1},
+    {"foo", 0x2639, -1},
+    {"foo", 'o', 1},
+    {"foo☺bar", 0x263A, 3},
+    {"foo☺☻☹bar", 0x2639, 9},
+    {"a A x", 'A', 2},
+    {"some_text=some_value", '=', 9},
+    {"☺a", 'a', 3},
+    {"a☻☺b", 0x263A, 4},
+    {"�", 0xFFFD, 0},
+    {"\xff", 0xFFFD, 0},
+    {"☻x�", 0xFFFD, 4},
+    {"☻x\xe2\x98", 0xFFFD, 4},
+    {"☻x\xe2\x98�", 0xFFFD, 4},
+    {"☻x\xe2\x98x", 0xFFFD, 4},
+    {"a☺b☻c☹d\xe2\x98�\xff�\xed\xa0\x80", 0xFFFFFFFF, -1},
+    {"a☺b☻c☹d\xe2\x98�\xff�\xed\xa0\x80", 0xD800, -1},
+    {"a☺b☻c☹d\xe2\x98�\xff�\xed\xa0\x80", 0x110000, -1},
+};
+
+TEST(search, TestIndexRune) {
+  for (index_rune_test const& t : kIndexRuneTests) {
+    string_view const s = View(t.s);
+    if (IndexRune(s, t.r) != t.index || ContainsRune(s, t.r) != (t.index >= 0)) {
+      FAIL() << "IndexRune(" << s << ", " << t.r << ") = " << IndexRune(s, t.r)
+             << ", want " << t.index;
+    }
+  }
+}
+
+struct index_any_test {
+  char const* s;
+  char const* chars;
+  int64 index;
+  int64 last_index;
+};
+
+index_any_test const kIndexAnyTests[] = {
+    {"", "", -1, -1},
+    {"", "a", -1, -1},
+    {"", "abc", -1, -1},
+    {"a", "", -1, -1},
+    {"a", "a", 0, 0},
+    {"\x80", "\xff", 0, 0},
+    {"aaa", "a", 0, 2},
+    {"abc", "xyz", -1, -1},
+    {"abc", "xcz", 2, 2},
+    {"ab☺c", "x☺yz", 2, 2},
+    {"a☺b☻c☹d", "cx", 8, 8},
+    {"a☺b☻c☹d", "uvw☻xyz", 5, 5},
+    {"aRegExp*", ".(|)*+?^$[]", 7, 7},
+    {"1....2....3....41....2....3....41....2....3....4", " ", -1, -1},
+    {"012abcba210", "\xff" "b", 4, 6},
+    {"012\x80" "bcb\x80" "210", "\xff" "b", 3, 7},
+    {"0123456\xcf\x80" "abc", "\xcf" "b\x80", 10, 10},
+    {"a☺b\xe2\x98日本語 日本語", "本 ", 10, 20},
+    {"x\xe6\x97日\xa5語", "語\xff", 1, 7},
+};
+
+TEST(search, TestIndexAny) {
+  for (index_any_test const& t : kIndexAnyTests) {
+    string_view const s = View(t.s);
+    string_view const chars = View(t.chars);
+    rune_set const set{chars};
+    if (IndexAny(s, chars) != t.index || IndexAny(s, set) != t.index ||
+        LastIndexAny(s, chars) != t.last_index ||
+        LastIndexAny(s, set) != t.last_index ||
+        ContainsAny(s, chars) != (t.index >= 0)) {
+      FAIL() << "IndexAny(" << s << ", " << chars << ") = "
+             << IndexAny(s, chars) << ", want " << t.index
+             << "; LastIndexAny = " << LastIndexAny(s, chars) << ", want "
+             << t.last_index;
+    }
+  }
+}
+
+TEST(search, TestRuneSet) {
+  rune_set set;
+  rune const members[] = {'\t', ',', 0x7F, 0x80, 0xE9, 0x65E5, 0xFFFD - 1,
+                          0x10000, 0x1F600, 0x10FFFF};
+  for (rune const r : members) {
+    set.Add(r);
+  }
+  set.Add(0xD800);
+  set.Add(0x110000);
+  for (rune r = 0; r <= 0x110000; ++r) {
+    bool const want =
+        std::find(std::begin(members), std::end(members), r) !=
+        std::end(members);
+    if (set.Contains(r) != want) {
+      FAIL() << "Contains(" << r << ") = " << !want;
+    }
+  }
+}
+
+// NaiveIndexAny and NaiveLastIndexAny decode s rune by rune.
+int64 NaiveIndexAny(string_view s, rune_set const& set) {
+  for (uint64 i = 0; i < s.Size();) {
+    auto const [r, size] = unicode::utf8::DecodeRuneInString(s.Substr(i));
+    if (set.Contains(r)) {
+      return i;
+    }
+    i += size;
+  }
+  return -1;
+}
+
+int64 NaiveLastIndexAny(string_view s, rune_set const& set) {
+  for (uint64 i = s.Size(); i > 0;) {
+    auto const [r, size] =
+        unicode::utf8::DecodeLastRuneInString(s.Substr(0, i));
+    i -= size;
+    if (set.Contains(r)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+TEST(search, TestIndexAnyRandom) {
+  // Pieces of text, some of them cut or invalid, with the runes of the sets
+  // among them.
+  char const* const pieces[] = {"a", ",", " ", "é", "日", "本", "😀", "\xe6\x97",
+                                "\xff", "\x80", "�", "\xf0\x9f"};
+  std::mt19937_64 rng{3};
+  for (int32 iter = 0; iter < 20000; ++iter) {
+    slice<uint8> s;
+    uint64 const pieces_in_s = rng() % 80;
+    for (uint64 i = 0; i < pieces_in_s; ++i) {
+      char const* const p = pieces[rng() % 12];
+      s.insert(s.end(), p, p + __builtin_strlen(p));
+    }
+    slice<uint8> chars;
+    uint64 const pieces_in_chars = rng() % 4;
+    for (uint64 i = 0; i < pieces_in_chars; ++i) {
+      // Leave out the invalid pieces most of the time, so that most sets
+      // are scanned by byte.
+      char const* const p = pieces[rng() % (iter % 4 == 0 ? 12 : 7)];
+      chars.insert(chars.end(), p, p + __builtin_strlen(p));
+    }
+    string_view const sv{s.data(), s.size()};
+    string_view const cv{chars.data(), chars.size()};
+    rune_set const set{cv};
+    if (IndexAny(sv, set) != NaiveIndexAny(sv, set) ||
+        IndexAny(sv, cv) != NaiveIndexAny(sv, set) ||
+        LastIndexAny(sv, set) != NaiveLastIndexAny(sv, set)) {
+      FAIL() << "IndexAny(" << sv << ", " << cv << ") = " << IndexAny(sv, set)
+             << ", want " << NaiveIndexAny(sv, set) << "; LastIndexAny = "
+             << LastIndexAny(sv, set) << ", want "
+             << NaiveLastIndexAny(sv, set);
+    }
+  }
+}
+
+}  // namespace rflx
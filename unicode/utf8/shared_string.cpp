@@ -0,0 +1,123 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+
+#include "unicode/utf8/shared_string.hpp"
+
+#include <new>
+
+namespace rflx {
+
+shared_string::shared_string(uint8 const* s, uint64 count) {
+  if (count == 0) {
+    return;
+  }
+  void* const p = ::operator new(sizeof(block) + count + 1);
+  block_ = new (p) block;
+  uint8* const data = static_cast<uint8*>(p) + sizeof(block);
+  __builtin_memcpy(data, s, count);
+  data[count] = '\n';
+  data_ = data;
+  size_ = count;
+}
+
+shared_string::shared_string(string_view s)
+    : shared_string(s.Data(), s.Size()) {}
+
+shared_string::shared_string(string&& s) {
+  if (s.Size() == 0) {
+    return;
+  }
+  block_ = new (::operator new(sizeof(block))) block;
+  block_->owned = std::move(s);
+  data_ = block_->owned.Data();
+  size_ = block_->owned.Size();
+}
+
+shared_string::shared_string(block* b, uint8 const* data, uint64 size)
+    : block_{b}, data_{data}, size_{size} {
+  if (block_ != nullptr) {
+    block_->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+shared_string::shared_string(shared_string const& o) noexcept
+    : shared_string(o.block_, o.data_, o.size_) {}
+
+shared_string& shared_string::operator=(shared_string const& o) noexcept {
+  if (o.block_ != nullptr) {
+    o.block_->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+  Release();
+  block_ = o.block_;
+  data_ = o.data_;
+  size_ = o.size_;
+  return *this;
+}
+
+shared_string::shared_string(shared_string&& o) noexcept
+    : block_{o.block_}, data_{o.data_}, size_{o.size_} {
+  o.block_ = nullptr;
+  o.data_ = nullptr;
+  o.size_ = 0;
+}
+
+shared_string& shared_string::operator=(shared_string&& o) noexcept {
+  if (&o != this) {
+    Release();
+    block_ = o.block_;
+    data_ = o.data_;
+    size_ = o.size_;
+    o.block_ = nullptr;
+    o.data_ = nullptr;
+    o.size_ = 0;
+  }
+  return *this;
+}
+
+shared_string::~shared_string() { Release(); }
+
+void shared_string::Release() {
+  if (block_ != nullptr &&
+      block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    block_->~block();
+    ::operator delete(block_);
+  }
+}
+
+string_iterator shared_string::begin() const noexcept {
+  return string_iterator{View()};
+}
+
+string_iterator shared_string::end() const noexcept {
+  return string_iterator{View(), size_};
+}
+
+bool shared_string::Empty() const { return size_ == 0; }
+
+uint64 shared_string::Size() const { return size_; }
+
+uint8 const* shared_string::Data() const { return data_; }
+
+string_view shared_string::View() const { return {data_, size_}; }
+
+shared_string shared_string::Substr(uint64 pos) const {
+  if (pos >= size_) {
+    return {};
+  }
+  return Substr(pos, size_ - pos);
+}
+
+shared_string shared_string::Substr(uint64 pos, uint64 size) const {
+  if (pos >= size_ || pos + size > size_) {
+    return {};
+  }
+  return {block_, data_ + pos, size};
+}
+
+int64 shared_string::UseCount() const {
+  return block_ == nullptr ? 0 : block_->refs.load(std::memory_order_relaxed);
+}
+
+}  // namespace rflx
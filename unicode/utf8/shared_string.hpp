@@ -0,0 +1,73 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+#pragma once
+
+#include <atomic>
+
+#include "types.hpp"
+#include "unicode/utf8/strings.hpp"
+
+namespace rflx {
+
+// shared_string is an immutable byte string whose buffer is shared by its
+// copies and freed with the last of them, so copying one costs an atomic
+// increment instead of a copy of the bytes. The count is atomic and copies
+// may be used and destroyed on different threads.
+//
+// A shared_string built from bytes holds its count and bytes in one
+// allocation. One built from a string takes over the string's buffer.
+class shared_string {
+ public:
+  shared_string() = default;
+  shared_string(uint8 const* s, uint64 count);
+  explicit shared_string(string_view s);
+  // The string is moved in; its bytes are not copied.
+  explicit shared_string(string&& s);
+
+  shared_string(shared_string const& o) noexcept;
+  shared_string& operator=(shared_string const& o) noexcept;
+
+  shared_string(shared_string&& o) noexcept;
+  shared_string& operator=(shared_string&& o) noexcept;
+
+  ~shared_string();
+
+  string_iterator begin() const noexcept;
+  string_iterator end() const noexcept;
+
+  bool Empty() const;
+  uint64 Size() const;
+  uint8 const* Data() const;
+
+  // View returns the bytes, which stay valid as long as some shared_string
+  // holds them.
+  string_view View() const;
+
+  // Substr returns bytes [pos, pos+size) as a shared_string that keeps the
+  // whole buffer alive. Like string_view::Substr, it returns an empty string
+  // if they are out of range.
+  shared_string Substr(uint64 pos) const;
+  shared_string Substr(uint64 pos, uint64 size) const;
+
+  // UseCount returns the number of shared_strings holding the buffer.
+  int64 UseCount() const;
+
+ private:
+  // block is the count, followed by the bytes or holding the string whose
+  // bytes they are.
+  struct block {
+    std::atomic<int64> refs{1};
+    string owned;
+  };
+
+  shared_string(block* b, uint8 const* data, uint64 size);
+  void Release();
+
+  block* block_ = nullptr;
+  uint8 const* data_ = nullptr;
+  uint64 size_ = 0;
+};
+
+}  // namespace rflx
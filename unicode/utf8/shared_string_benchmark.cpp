@@ -0,0 +1,42 @@
+#include "benchmark/benchmark.h"
+#include "types.hpp"
+#include "unicode/utf8/shared_string.hpp"
+
+namespace rflx {
+
+namespace {
+
+constexpr int64 kBodySize = 4096;
+constexpr int64 kConsumers = 16;
+
+// BenchmarkFanOutClone hands each consumer its own copy of a message body.
+void BenchmarkFanOutClone(benchmark::State& state) {
+  string body(kBodySize, 'x');
+  slice<string> consumers(kConsumers);
+  for (auto _ : state) {
+    for (string& c : consumers) {
+      c = body.Clone();
+    }
+    benchmark::DoNotOptimize(consumers.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kConsumers);
+}
+BENCHMARK(BenchmarkFanOutClone);
+
+// BenchmarkFanOutShared hands each consumer a shared_string of the body.
+void BenchmarkFanOutShared(benchmark::State& state) {
+  shared_string const body{string(kBodySize, 'x')};
+  slice<shared_string> consumers(kConsumers);
+  for (auto _ : state) {
+    for (shared_string& c : consumers) {
+      c = body;
+    }
+    benchmark::DoNotOptimize(consumers.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kConsumers);
+}
+BENCHMARK(BenchmarkFanOutShared);
+
+}  // namespace
+
+}  // namespace rflx
@@ -0,0 +1,104 @@
+#include "unicode/utf8/shared_string.hpp"
+
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "types.hpp"
+
+namespace rflx {
+
+bool Equal(string_view s, char const* want) {
+  uint64 const n = __builtin_strlen(want);
+  return s.Size() == n && std::equal(want, want + n, s.Data());
+}
+
+TEST(shared_string, TestSharedString) {
+  char const* const text = "a string long enough to live on the heap";
+  shared_string const s{string_view{(uint8 const*)text}};
+  if (!Equal(s.View(), text) || s.Data()[s.Size()] != '\n' ||
+      s.UseCount() != 1) {
+    FAIL() << "s = " << s.View() << ", UseCount() = " << s.UseCount();
+  }
+
+  shared_string c = s;
+  if (c.Data() != s.Data() || s.UseCount() != 2) {
+    FAIL() << "copy did not share the buffer";
+  }
+  shared_string const sub = s.Substr(2, 6);
+  if (!Equal(sub.View(), "string") || sub.Data() != s.Data() + 2 ||
+      s.UseCount() != 3) {
+    FAIL() << "Substr(2, 6) = " << sub.View();
+  }
+  if (!s.Substr(100).Empty() || !s.Substr(2, 100).Empty() ||
+      s.Substr(100).UseCount() != 0) {
+    FAIL() << "out of range Substr is not empty";
+  }
+
+  shared_string m = std::move(c);
+  if (!c.Empty() || c.UseCount() != 0 || m.Data() != s.Data() ||
+      s.UseCount() != 3) {
+    FAIL() << "move";
+  }
+  m = sub;
+  shared_string& alias = m;
+  m = alias;
+  if (!Equal(m.View(), "string") || s.UseCount() != 3) {
+    FAIL() << "assignment";
+  }
+  m = shared_string{};
+  if (!m.Empty() || s.UseCount() != 2) {
+    FAIL() << "assignment of an empty string";
+  }
+
+  if (!shared_string{string_view{}}.Empty() ||
+      shared_string{string{}}.UseCount() != 0) {
+    FAIL() << "empty strings hold a buffer";
+  }
+}
+
+TEST(shared_string, TestSharedStringFromString) {
+  char const* const text = "a string long enough to live on the heap";
+  string long_string{(uint8 const*)text};
+  uint8 const* const bytes = long_string.Data();
+  shared_string const s{std::move(long_string)};
+  if (s.Data() != bytes || !Equal(s.View(), text) || long_string.Size() != 0) {
+    FAIL() << "heap string was copied";
+  }
+
+  string short_string{(uint8 const*)"short"};
+  shared_string const t{std::move(short_string)};
+  shared_string const u = t;
+  if (!Equal(t.View(), "short") || u.Data() != t.Data() ||
+      t.Data()[t.Size()] != '\n') {
+    FAIL() << "t = " << t.View();
+  }
+
+  pool p;
+  shared_string const r{string{(uint8 const*)text, 40, &p}};
+  if (!Equal(r.View(), text)) {
+    FAIL() << "r = " << r.View();
+  }
+}
+
+TEST(shared_string, TestSharedStringConcurrent) {
+  constexpr int32 kThreads = 8;
+  constexpr int32 kCopies = 10000;
+  shared_string const s{string_view{(uint8 const*)"shared across threads"}};
+  slice<std::thread> threads;
+  for (int32 t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&s, t] {
+      slice<shared_string> copies;
+      for (int32 i = 0; i < kCopies; ++i) {
+        copies.push_back(i % 2 == 0 ? s : s.Substr(t));
+      }
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+  if (s.UseCount() != 1) {
+    FAIL() << "UseCount() = " << s.UseCount() << " after the threads, want 1";
+  }
+}
+
+}  // namespace rflx
@@ -0,0 +1,158 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+
+#include "unicode/utf8/sink.hpp"
+
+#include <sys/uio.h>
+
+#include <cerrno>
+#include <climits>
+
+#include "unicode/utf8/utf8.hpp"
+
+namespace rflx {
+
+namespace {
+
+// kMaxIovecs bounds the iovecs passed to one writev by IOV_MAX, or by the
+// least IOV_MAX POSIX allows where it is not defined.
+#ifdef IOV_MAX
+constexpr uint64 kMaxIovecs =
+    sink::kMaxParts < uint64{IOV_MAX} ? sink::kMaxParts : uint64{IOV_MAX};
+#else
+constexpr uint64 kMaxIovecs = 16;
+#endif
+
+}  // namespace
+
+sink::sink(uint64 size) : buf_(size) {}
+
+bool sink::Write(string_view s) {
+  if (s.Size() <= buf_.size() - n_) {
+    if (!ok_) {
+      return false;
+    }
+    if (s.Size() > 0) {
+      __builtin_memcpy(buf_.data() + n_, s.Data(), s.Size());
+      n_ += s.Size();
+    }
+    return true;
+  }
+  return Write(span<string_view const>{&s, 1});
+}
+
+bool sink::Write(span<string_view const> parts) {
+  if (!ok_) {
+    return false;
+  }
+  uint64 total = 0;
+  for (string_view const& p : parts) {
+    total += p.Size();
+  }
+  if (total <= buf_.size() - n_) {
+    for (string_view const& p : parts) {
+      if (p.Size() > 0) {
+        __builtin_memcpy(buf_.data() + n_, p.Data(), p.Size());
+        n_ += p.Size();
+      }
+    }
+    return true;
+  }
+  string_view out[kMaxParts];
+  uint64 k = 0;
+  if (n_ > 0) {
+    out[k++] = {buf_.data(), n_};
+  }
+  n_ = 0;
+  for (string_view const& p : parts) {
+    if (p.Size() == 0) {
+      continue;
+    }
+    if (k == kMaxParts) {
+      if (!WriteOut({out, k})) {
+        ok_ = false;
+        return false;
+      }
+      k = 0;
+    }
+    out[k++] = p;
+  }
+  ok_ = WriteOut({out, k});
+  return ok_;
+}
+
+bool sink::WriteRune(rune r) {
+  if (!ok_) {
+    return false;
+  }
+  if (buf_.size() - n_ >= unicode::utf8::kUTFMax) {
+    if (r < unicode::utf8::kRuneSelf) {
+      buf_[n_++] = static_cast<uint8>(r);
+      return true;
+    }
+    n_ += unicode::utf8::EncodeRune(
+        {buf_.data() + n_, unicode::utf8::kUTFMax}, r);
+    return true;
+  }
+  uint8 b[unicode::utf8::kUTFMax];
+  int32 const n = unicode::utf8::EncodeRune({b, unicode::utf8::kUTFMax}, r);
+  return Write(string_view{b, static_cast<uint64>(n)});
+}
+
+bool sink::Flush() {
+  if (!ok_ || n_ == 0) {
+    return ok_;
+  }
+  string_view const b{buf_.data(), n_};
+  n_ = 0;
+  ok_ = WriteOut({&b, 1});
+  return ok_;
+}
+
+uint64 sink::Buffered() const { return n_; }
+
+bool sink::Ok() const { return ok_; }
+
+fd_sink::fd_sink(int32 fd, uint64 size) : sink(size), fd_{fd} {}
+
+fd_sink::~fd_sink() { Flush(); }
+
+int32 fd_sink::Error() const { return error_; }
+
+bool fd_sink::WriteOut(span<string_view const> parts) {
+  iovec iov[kMaxIovecs];
+  while (!parts.empty()) {
+    uint64 n = 0;
+    for (; n < kMaxIovecs && n < parts.size(); ++n) {
+      iov[n] = {const_cast<uint8*>(parts[n].Data()), parts[n].Size()};
+    }
+    parts.remove_prefix(n);
+    // writev may write less than asked; skip what it wrote and go again.
+    iovec* v = iov;
+    while (n > 0) {
+      ssize_t const w = writev(fd_, v, static_cast<int32>(n));
+      if (w < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        error_ = errno;
+        return false;
+      }
+      uint64 done = w;
+      while (n > 0 && done >= v->iov_len) {
+        done -= v->iov_len;
+        ++v;
+        --n;
+      }
+      if (n > 0) {
+        v->iov_base = static_cast<uint8*>(v->iov_base) + done;
+        v->iov_len -= done;
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace rflx
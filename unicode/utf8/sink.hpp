@@ -0,0 +1,75 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+#pragma once
+
+#include "types.hpp"
+#include "unicode/utf8/strings.hpp"
+
+namespace rflx {
+
+// sink collects writes in a buffer and passes them on in large pieces.
+// Writes that do not fit in the buffer go out together with the buffered
+// bytes, without being copied into the buffer.
+//
+// After an error, writes are dropped and every call returns false.
+class sink {
+ public:
+  static constexpr uint64 kDefaultSize = uint64{64} << 10;
+  // kMaxParts bounds the parts passed to one WriteOut. Longer lists are
+  // passed on in pieces, so that a write never allocates.
+  static constexpr uint64 kMaxParts = 64;
+
+  sink(sink const&) = delete;
+  sink& operator=(sink const&) = delete;
+
+  virtual ~sink() = default;
+
+  // Write appends s.
+  bool Write(string_view s);
+  // Write appends parts, in order.
+  bool Write(span<string_view const> parts);
+  // WriteRune appends the UTF-8 encoding of r, or of RuneError if r is not a
+  // valid rune.
+  bool WriteRune(rune r);
+  // Flush passes on the buffered bytes.
+  bool Flush();
+
+  // Buffered returns the number of bytes waiting in the buffer.
+  uint64 Buffered() const;
+  bool Ok() const;
+
+ protected:
+  explicit sink(uint64 size = kDefaultSize);
+
+  // WriteOut writes all of parts, in order, to the destination. There are at
+  // most kMaxParts of them.
+  virtual bool WriteOut(span<string_view const> parts) = 0;
+
+ private:
+  slice<uint8> buf_;
+  uint64 n_ = 0;
+  bool ok_ = true;
+};
+
+// fd_sink writes to a file descriptor, with one writev for the buffer and
+// the writes that overflow it. It flushes when destroyed but does not close
+// the descriptor.
+class fd_sink : public sink {
+ public:
+  explicit fd_sink(int32 fd, uint64 size = kDefaultSize);
+  ~fd_sink() override;
+
+  // Error returns the errno of the write that failed, or 0.
+  int32 Error() const;
+
+ protected:
+  bool WriteOut(span<string_view const> parts) override;
+
+ private:
+  int32 fd_;
+  int32 error_ = 0;
+};
+
+}  // namespace rflx
@@ -0,0 +1,61 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <fstream>
+
+#include "benchmark/benchmark.h"
+#include "types.hpp"
+#include "unicode/utf8/sink.hpp"
+
+namespace rflx {
+
+namespace {
+
+constexpr uint64 kLineSize = 120;
+
+// BenchmarkOstreamString writes a string of state.range(0) bytes with
+// operator<<.
+void BenchmarkOstreamString(benchmark::State& state) {
+  string const s(state.range(0), 'x');
+  std::ofstream out{"/dev/null"};
+  for (auto _ : state) {
+    out << s;
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BenchmarkOstreamString)->Arg(kLineSize)->Arg(1 << 20);
+
+// BenchmarkSinkLines writes log lines of a prefix, a message and a newline.
+void BenchmarkSinkLines(benchmark::State& state) {
+  string const prefix(24, 'p');
+  string const message(kLineSize - 25, 'm');
+  string_view const parts[] = {{prefix.Data(), prefix.Size()},
+                               {message.Data(), message.Size()},
+                               {(uint8 const*)"\n", 1}};
+  int32 const fd = open("/dev/null", O_WRONLY);
+  {
+    fd_sink out{fd};
+    for (auto _ : state) {
+      out.Write(parts);
+    }
+  }
+  close(fd);
+  state.SetBytesProcessed(state.iterations() * kLineSize);
+}
+BENCHMARK(BenchmarkSinkLines);
+
+// BenchmarkOstreamLines writes the same lines to a std::ofstream.
+void BenchmarkOstreamLines(benchmark::State& state) {
+  string const prefix(24, 'p');
+  string const message(kLineSize - 25, 'm');
+  std::ofstream out{"/dev/null"};
+  for (auto _ : state) {
+    out << prefix << message << '\n';
+  }
+  state.SetBytesProcessed(state.iterations() * kLineSize);
+}
+BENCHMARK(BenchmarkOstreamLines);
+
+}  // namespace
+
+}  // namespace rflx
@@ -0,0 +1,132 @@
+#include "unicode/utf8/sink.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "types.hpp"
+
+namespace rflx {
+
+// Contents returns what has been written to f.
+slice<uint8> Contents(std::FILE* f) {
+  slice<uint8> b(1 << 16);
+  ssize_t const n = pread(fileno(f), b.data(), b.size(), 0);
+  b.resize(n < 0 ? 0 : n);
+  return b;
+}
+
+string_view View(char const* s) { return {(uint8 const*)s}; }
+
+bool Equal(slice<uint8> const& got, char const* want) {
+  string_view const w = View(want);
+  return got.size() == w.Size() && std::equal(got.begin(), got.end(), w.Data());
+}
+
+TEST(sink, TestFdSink) {
+  std::FILE* const f = std::tmpfile();
+  {
+    fd_sink out{fileno(f), 8};
+    if (!out.Write(View("abc")) || !out.WriteRune(0x65E5) ||
+        out.Buffered() != 6 || !Contents(f).empty()) {
+      FAIL() << "small writes were not buffered";
+    }
+    // Neither part fits; both go out behind the buffered bytes.
+    string_view const parts[] = {View("defgh"), View(""), View("ijklmnop")};
+    if (!out.Write(parts) || out.Buffered() != 0 ||
+        !Equal(Contents(f), "abc日defghijklmnop")) {
+      FAIL() << "gathered write";
+    }
+    // The first rune fills the buffer; the second goes out behind it.
+    if (!out.Write(View("qrst")) || !out.WriteRune(0x10FFFF) ||
+        out.Buffered() != 8 || !out.WriteRune(0xD800) ||
+        out.Buffered() != 0 ||
+        !Equal(Contents(f), "abc日defghijklmnopqrst\U0010FFFF�")) {
+      FAIL() << "runes around a full buffer";
+    }
+    if (!out.Write(View("uv")) || out.Buffered() != 2) {
+      FAIL() << "Buffered() = " << out.Buffered() << ", want 2";
+    }
+  }
+  if (!Equal(Contents(f), "abc日defghijklmnopqrst\U0010FFFF�uv")) {
+    FAIL() << "destructor did not flush";
+  }
+  std::fclose(f);
+}
+
+TEST(sink, TestFdSinkUnbuffered) {
+  std::FILE* const f = std::tmpfile();
+  fd_sink out{fileno(f), 0};
+  if (!out.Write(View("abc")) || !out.WriteRune('d') ||
+      !out.WriteRune(0x65E5) || !Equal(Contents(f), "abcd日")) {
+    FAIL() << "unbuffered writes";
+  }
+  std::fclose(f);
+}
+
+TEST(sink, TestFdSinkManyParts) {
+  std::FILE* const f = std::tmpfile();
+  fd_sink out{fileno(f), 16};
+  slice<string_view> parts(1000, View("x"));
+  slice<uint8> want(1000, 'x');
+  if (!out.Write(parts) || !out.Flush() || Contents(f) != want) {
+    FAIL() << "more parts than one writev takes";
+  }
+  std::fclose(f);
+}
+
+// parts_sink records what is passed to WriteOut.
+class parts_sink : public sink {
+ public:
+  explicit parts_sink(uint64 size) : sink(size) {}
+
+  slice<uint8> bytes;
+  uint64 calls = 0;
+  uint64 max_parts = 0;
+
+ protected:
+  bool WriteOut(span<string_view const> parts) override {
+    ++calls;
+    max_parts = parts.size() > max_parts ? parts.size() : max_parts;
+    for (string_view const& p : parts) {
+      bytes.insert(bytes.end(), p.Data(), p.Data() + p.Size());
+    }
+    return true;
+  }
+};
+
+TEST(sink, TestSinkManyParts) {
+  parts_sink out{4};
+  slice<string_view> parts;
+  std::string want = "ab";
+  for (int32 i = 0; i < 200; ++i) {
+    parts.push_back(i % 3 == 0 ? View("") : View("xyz"));
+    want += i % 3 == 0 ? "" : "xyz";
+  }
+  // The buffered bytes lead the first piece; the empty parts are dropped.
+  if (!out.Write(View("ab")) || !out.Write(parts) || out.Buffered() != 0 ||
+      out.max_parts > sink::kMaxParts || out.calls != 3 ||
+      !Equal(out.bytes, want.c_str())) {
+    FAIL() << out.calls << " calls of up to " << out.max_parts << " parts, "
+           << out.bytes.size() << " bytes, want " << want.size();
+  }
+}
+
+TEST(sink, TestFdSinkError) {
+  int32 const fd = open("/dev/null", O_RDONLY);
+  fd_sink out{fd, 4};
+  if (out.Write(View("too long")) || out.Ok() || out.Error() != EBADF) {
+    FAIL() << "Error() = " << out.Error() << ", want EBADF";
+  }
+  if (out.Write(View("a")) || out.WriteRune('a') || out.Flush() ||
+      out.Buffered() != 0) {
+    FAIL() << "writes after an error were accepted";
+  }
+  close(fd);
+}
+
+}  // namespace rflx
@@ -0,0 +1,158 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+
+#include "unicode/utf8/source.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+
+#include "unicode/utf8/utf8.hpp"
+
+namespace rflx {
+
+source::source(uint64 size, memory_resource* resource)
+    : buf_(std::max(size, kMinSize),
+           resource == nullptr ? std::pmr::new_delete_resource() : resource) {}
+
+void source::Fill() {
+  if (r_ > 0) {
+    __builtin_memmove(buf_.data(), buf_.data() + r_, w_ - r_);
+    w_ -= r_;
+    r_ = 0;
+  }
+  if (done_ || w_ == buf_.size()) {
+    return;
+  }
+  int64 const n = ReadIn({buf_.data() + w_, buf_.size() - w_});
+  if (n <= 0) {
+    done_ = true;
+    ok_ = n == 0;
+    return;
+  }
+  w_ += n;
+}
+
+pair<rune, int8> source::ReadRune() {
+  last_ = 0;
+  // A rune cut at the end of the buffer is completed before decoding it.
+  while (w_ - r_ < unicode::utf8::kUTFMax && !done_ &&
+         !unicode::utf8::FullRune({buf_.data() + r_, w_ - r_})) {
+    Fill();
+  }
+  if (r_ == w_) {
+    return {unicode::utf8::kRuneError, 0};
+  }
+  uint8 const c = buf_[r_];
+  if (c < unicode::utf8::kRuneSelf) {
+    ++r_;
+    last_ = 1;
+    return {c, 1};
+  }
+  auto const [r, size] =
+      unicode::utf8::DecodeRune({buf_.data() + r_, w_ - r_});
+  r_ += size;
+  last_ = size;
+  return {r, size};
+}
+
+bool source::UnreadRune() {
+  if (last_ == 0) {
+    return false;
+  }
+  r_ -= last_;
+  last_ = 0;
+  return true;
+}
+
+pair<string_view, bool> source::ReadSlice(uint8 delim) {
+  last_ = 0;
+  uint64 searched = 0;
+  while (true) {
+    uint8 const* const start = buf_.data() + r_;
+    void const* const found = __builtin_memchr(
+        start + searched, delim, w_ - r_ - searched);
+    if (found != nullptr) {
+      uint64 const n = static_cast<uint8 const*>(found) - start + 1;
+      r_ += n;
+      return {{start, n}, true};
+    }
+    if (done_ || w_ - r_ == buf_.size()) {
+      string_view const rest{start, w_ - r_};
+      r_ = w_;
+      return {rest, false};
+    }
+    searched = w_ - r_;
+    Fill();
+  }
+}
+
+pair<source::line, bool> source::ReadLine() {
+  auto const [s, found] = ReadSlice('\n');
+  uint8 const* const data = s.Data();
+  uint64 size = s.Size();
+  if (!found) {
+    if (size == 0) {
+      return {{}, false};
+    }
+    if (size < buf_.size()) {
+      return {{s, false}, true};
+    }
+    // Keep a trailing '\r' back in case the '\n' of a "\r\n" comes next.
+    if (data[size - 1] == '\r') {
+      --r_;
+      --size;
+    }
+    return {{{data, size}, true}, true};
+  }
+  --size;
+  if (size > 0 && data[size - 1] == '\r') {
+    --size;
+  }
+  return {{{data, size}, false}, true};
+}
+
+uint64 source::Buffered() const { return w_ - r_; }
+
+bool source::Ok() const { return ok_; }
+
+fd_source::fd_source(int32 fd, uint64 size, memory_resource* resource)
+    : source(size, resource), fd_{fd} {}
+
+void fd_source::Sequential() {
+  posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+}
+
+int32 fd_source::Error() const { return error_; }
+
+int64 fd_source::ReadIn(span<uint8> p) {
+  while (true) {
+    ssize_t const n = read(fd_, p.data(), p.size());
+    if (n >= 0) {
+      return n;
+    }
+    if (errno != EINTR) {
+      error_ = errno;
+      return -1;
+    }
+  }
+}
+
+memory_source::memory_source(string_view s, uint64 size,
+                             memory_resource* resource)
+    : source(size, resource), s_{s} {}
+
+int64 memory_source::ReadIn(span<uint8> p) {
+  uint64 const n = std::min<uint64>(p.size(), s_.Size());
+  if (n > 0) {
+    __builtin_memcpy(p.data(), s_.Data(), n);
+  }
+  s_ = s_.Substr(n);
+  return n;
+}
+
+}  // namespace rflx
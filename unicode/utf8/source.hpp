@@ -0,0 +1,112 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+#pragma once
+
+#include "types.hpp"
+#include "unicode/utf8/strings.hpp"
+
+namespace rflx {
+
+// source reads its input in large pieces into a buffer of fixed size and
+// hands it out by rune or by line, so reading a file of any size takes
+// constant memory. Views it returns point into the buffer and are valid
+// until the next call.
+class source {
+ public:
+  static constexpr uint64 kDefaultSize = uint64{64} << 10;
+  // kMinSize is the smallest buffer; smaller sizes are rounded up to it.
+  static constexpr uint64 kMinSize = 16;
+
+  // line is a line returned by ReadLine.
+  struct line {
+    string_view text;
+    // prefix is set if text is the start of a line that does not fit in the
+    // buffer; the rest of the line follows in the next calls.
+    bool prefix = false;
+  };
+
+  source(source const&) = delete;
+  source& operator=(source const&) = delete;
+
+  virtual ~source() = default;
+
+  // ReadRune reads one rune and returns it with its width, like DecodeRune.
+  // It returns (RuneError, 0) at the end of the input or on error.
+  pair<rune, int8> ReadRune();
+  // UnreadRune steps back over the rune returned by the last call, if that
+  // call was a ReadRune that read one.
+  bool UnreadRune();
+
+  // ReadSlice reads up to and including the first delim and reports whether
+  // it found one. Without it, it returns what was left at the end of the
+  // input or on error, or the whole buffer if it is full.
+  pair<string_view, bool> ReadSlice(uint8 delim);
+  // ReadLine reads a line and returns it without its "\n" or "\r\n". It
+  // returns false at the end of the input or on error.
+  pair<line, bool> ReadLine();
+
+  // Buffered returns the number of bytes read in but not yet handed out.
+  uint64 Buffered() const;
+  bool Ok() const;
+
+ protected:
+  // The buffer comes from resource, or from the heap if it is null.
+  explicit source(uint64 size = kDefaultSize,
+                  memory_resource* resource = nullptr);
+
+  // ReadIn reads into p and returns the number of bytes read, 0 at the end
+  // of the input, or -1 on error.
+  virtual int64 ReadIn(span<uint8> p) = 0;
+
+ private:
+  // Fill moves the unread bytes to the front of the buffer and reads more
+  // after them.
+  void Fill();
+
+  pmr::slice<uint8> buf_;
+  uint64 r_ = 0;
+  uint64 w_ = 0;
+  // last_ is the width of the rune UnreadRune would step back over, or 0.
+  int8 last_ = 0;
+  bool done_ = false;
+  bool ok_ = true;
+};
+
+// fd_source reads from a file descriptor. It does not close it.
+class fd_source : public source {
+ public:
+  explicit fd_source(int32 fd, uint64 size = kDefaultSize,
+                     memory_resource* resource = nullptr);
+
+  // Sequential advises the kernel that the file is read once, in order, so
+  // it reads further ahead.
+  void Sequential();
+
+  // Error returns the errno of the read that failed, or 0.
+  int32 Error() const;
+
+ protected:
+  int64 ReadIn(span<uint8> p) override;
+
+ private:
+  int32 fd_;
+  int32 error_ = 0;
+};
+
+// memory_source reads bytes that are already in memory, which must outlive
+// it.
+class memory_source : public source {
+ public:
+  explicit memory_source(string_view s, uint64 size = kDefaultSize,
+                         memory_resource* resource = nullptr);
+
+ protected:
+  int64 ReadIn(span<uint8> p) override;
+
+ private:
+  string_view s_;
+};
+
+}  // namespace rflx
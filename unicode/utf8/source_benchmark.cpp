@@ -0,0 +1,87 @@
+#include <unistd.h>
+
+#include <cstdio>
+
+#include "benchmark/benchmark.h"
+#include "types.hpp"
+#include "unicode/utf8/source.hpp"
+
+namespace rflx {
+
+namespace {
+
+constexpr int64 kLines = 1 << 14;
+
+// Text returns kLines lines of the given text.
+slice<uint8> Text(char const* line) {
+  slice<uint8> b;
+  for (int64 i = 0; i < kLines; ++i) {
+    for (char const* c = line; *c != '\0'; ++c) {
+      b.push_back(*c);
+    }
+    b.push_back('\n');
+  }
+  return b;
+}
+
+// BenchmarkReadLine reads log lines held in memory.
+void BenchmarkReadLine(benchmark::State& state) {
+  slice<uint8> const text =
+      Text("2024-01-01T00:00:00Z INFO service started, listening on :8080");
+  for (auto _ : state) {
+    memory_source in{{text.data(), text.size()}};
+    int64 n = 0;
+    while (in.ReadLine().second) {
+      ++n;
+    }
+    benchmark::DoNotOptimize(n);
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BenchmarkReadLine);
+
+// BenchmarkReadLineFile reads the same lines from a file.
+void BenchmarkReadLineFile(benchmark::State& state) {
+  slice<uint8> const text =
+      Text("2024-01-01T00:00:00Z INFO service started, listening on :8080");
+  std::FILE* const f = std::tmpfile();
+  if (pwrite(fileno(f), text.data(), text.size(), 0) !=
+      static_cast<ssize_t>(text.size())) {
+    state.SkipWithError("pwrite");
+  }
+  for (auto _ : state) {
+    lseek(fileno(f), 0, SEEK_SET);
+    fd_source in{fileno(f)};
+    int64 n = 0;
+    while (in.ReadLine().second) {
+      ++n;
+    }
+    benchmark::DoNotOptimize(n);
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+  std::fclose(f);
+}
+BENCHMARK(BenchmarkReadLineFile);
+
+// BenchmarkReadRuneJapanese reads Japanese text rune by rune.
+void BenchmarkReadRuneJapanese(benchmark::State& state) {
+  slice<uint8> const text = Text("日本語の文章を一文字ずつ読み込みます。");
+  for (auto _ : state) {
+    memory_source in{{text.data(), text.size()}};
+    rune sum = 0;
+    while (true) {
+      auto const [r, size] = in.ReadRune();
+      if (size == 0) {
+        break;
+      }
+      sum += r;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BenchmarkReadRuneJapanese);
+
+}  // namespace
+
+}  // namespace rflx
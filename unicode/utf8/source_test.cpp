@@ -0,0 +1,147 @@
+#include "unicode/utf8/source.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+
+#include "gtest/gtest.h"
+#include "types.hpp"
+#include "unicode/utf8/utf8.hpp"
+
+namespace rflx {
+
+string_view View(char const* s) { return {(uint8 const*)s}; }
+
+bool Equal(string_view got, string_view want) {
+  return got.Size() == want.Size() &&
+         std::equal(got.Data(), got.Data() + got.Size(), want.Data());
+}
+
+TEST(source, TestReadRune) {
+  // Every buffer size cuts the runes at a different place.
+  string_view const text = View("aé日本\U0001F600\xff\xe6\x97z\xf0\x9f");
+  for (uint64 size : {16, 17, 18, 19, 64}) {
+    memory_source in{text, size};
+    uint64 offset = 0;
+    while (offset < text.Size()) {
+      auto const want = unicode::utf8::DecodeRuneInString(text.Substr(offset));
+      auto const got = in.ReadRune();
+      if (got != want) {
+        FAIL() << "size " << size << ", offset " << offset << ": got ("
+               << got.first << ", " << int(got.second) << "), want ("
+               << want.first << ", " << int(want.second) << ")";
+      }
+      if (offset % 3 == 0 &&
+          (!in.UnreadRune() || in.UnreadRune() || in.ReadRune() != want)) {
+        FAIL() << "size " << size << ", offset " << offset << ": UnreadRune";
+      }
+      offset += want.second;
+    }
+    if (in.ReadRune() != pair<rune, int8>{unicode::utf8::kRuneError, 0} ||
+        in.UnreadRune() || !in.Ok()) {
+      FAIL() << "size " << size << ": end of input";
+    }
+  }
+}
+
+TEST(source, TestReadLine) {
+  string_view const text =
+      View("one\r\ntwo\n\nthe third line is long enough to be cut\r\n\r\nlast");
+  struct want_line {
+    char const* text;
+    bool prefix;
+  };
+  want_line const want[] = {
+      {"one", false},
+      {"two", false},
+      {"", false},
+      {"the third line i", true},
+      {"s long enough to", true},
+      {" be cut", false},
+      {"", false},
+      {"last", false},
+  };
+  memory_source in{text, 16};
+  for (want_line const& w : want) {
+    auto const [l, ok] = in.ReadLine();
+    if (!ok || !Equal(l.text, View(w.text)) || l.prefix != w.prefix) {
+      FAIL() << "got " << l.text << ", want " << w.text;
+    }
+  }
+  if (in.ReadLine().second || !in.Ok()) {
+    FAIL() << "ReadLine at the end of the input";
+  }
+
+  // A "\r\n" cut by the end of a full buffer still ends the line.
+  memory_source cut{View("0123456789abcde\r\nx"), 16};
+  auto const [first, first_ok] = cut.ReadLine();
+  if (!first_ok || !Equal(first.text, View("0123456789abcde")) ||
+      !first.prefix) {
+    FAIL() << "\\r\\n across a full buffer: " << first.text;
+  }
+  auto const [second, second_ok] = cut.ReadLine();
+  if (!second_ok || !second.text.Empty() || second.prefix) {
+    FAIL() << "\\r\\n across a full buffer: " << second.text;
+  }
+}
+
+TEST(source, TestReadSlice) {
+  memory_source in{View("a,bc,,def"), 16};
+  char const* const want[] = {"a,", "bc,", ",", "def"};
+  for (uint64 i = 0; i < 4; ++i) {
+    auto const [s, found] = in.ReadSlice(',');
+    if (!Equal(s, View(want[i])) || found != (i < 3)) {
+      FAIL() << "got " << s << ", want " << want[i];
+    }
+  }
+  auto const [s, found] = in.ReadSlice(',');
+  if (!s.Empty() || found || in.Buffered() != 0) {
+    FAIL() << "ReadSlice at the end of the input";
+  }
+}
+
+TEST(source, TestFdSource) {
+  std::FILE* const f = std::tmpfile();
+  slice<uint8> text;
+  for (int32 i = 0; i < 1000; ++i) {
+    for (char const c : "line 日本語\n") {
+      if (c != '\0') {
+        text.push_back(c);
+      }
+    }
+  }
+  ASSERT_EQ(pwrite(fileno(f), text.data(), text.size(), 0),
+            static_cast<ssize_t>(text.size()));
+  pool p;
+  fd_source in{fileno(f), 100, &p};
+  in.Sequential();
+  int64 lines = 0;
+  while (true) {
+    auto const [l, ok] = in.ReadLine();
+    if (!ok) {
+      break;
+    }
+    if (!Equal(l.text, View("line 日本語")) || l.prefix) {
+      FAIL() << "line " << lines << " is " << l.text;
+    }
+    ++lines;
+  }
+  if (lines != 1000 || !in.Ok() || in.Error() != 0) {
+    FAIL() << lines << " lines, want 1000";
+  }
+  std::fclose(f);
+}
+
+TEST(source, TestFdSourceError) {
+  int32 const fd = open("/dev/null", O_WRONLY);
+  fd_source in{fd};
+  if (in.ReadRune().second != 0 || in.ReadLine().second || in.Ok() ||
+      in.Error() != EBADF) {
+    FAIL() << "Error() = " << in.Error() << ", want EBADF";
+  }
+  close(fd);
+}
+
+}  // namespace rflx
@@ -0,0 +1,144 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+#pragma once
+
+#include "types.hpp"
+#include "unicode/utf8/search.hpp"
+#include "unicode/utf8/strings.hpp"
+#include "unicode/utf8/utf8.hpp"
+
+namespace rflx {
+
+// The splits are ranges that find each field as they reach it. The fields
+// are views into the string being split, which must outlive them; nothing is
+// allocated or copied.
+
+// IsSpace reports whether r is white space as defined by Unicode's
+// White_Space property, that is '\t', '\n', '\v', '\f', '\r', ' ', U+0085
+// (NEL), U+00A0 (NBSP) and the separators of category Z.
+constexpr bool IsSpace(rune r);
+
+// split_iterator steps through the fields of a Split.
+class split_iterator {
+ public:
+  using self_type = split_iterator;
+  using value_type = string_view;
+  using iterator_category = std::forward_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+
+  constexpr split_iterator() = default;
+  // The iterator starts at the first field of s split around sep, keeping
+  // save bytes of each sep at the end of the field before it, into at most
+  // n fields if n >= 0.
+  constexpr split_iterator(string_view s, string_view sep, uint64 save,
+                           int64 n);
+
+  constexpr self_type& operator++();
+  constexpr self_type operator++(int);
+  constexpr value_type operator*() const;
+  constexpr bool operator==(self_type const& o) const;
+  constexpr bool operator!=(self_type const& o) const;
+
+ private:
+  constexpr void Next();
+
+  string_view rest_;
+  string_view sep_;
+  string_view field_;
+  uint64 save_ = 0;
+  // left_ is the number of fields left, or negative if there is no limit.
+  int64 left_ = -1;
+  // more_ is set while rest_ still holds a field.
+  bool more_ = false;
+  bool done_ = true;
+};
+
+// split_range is the fields of a string split around a separator.
+class split_range {
+ public:
+  constexpr split_range(string_view s, string_view sep, uint64 save, int64 n);
+
+  constexpr split_iterator begin() const;
+  constexpr split_iterator end() const;
+
+ private:
+  string_view s_;
+  string_view sep_;
+  uint64 save_;
+  int64 n_;
+};
+
+// Split returns the fields of s between the instances of sep. If s does not
+// contain sep, the only field is s. If sep is empty, each rune of s is a
+// field, with each byte of an invalid sequence a field of its own.
+constexpr split_range Split(string_view s, string_view sep);
+
+// SplitN is like Split but stops at n fields, the last of which is the rest
+// of s. If n is 0 there are no fields; if it is negative there is no limit.
+constexpr split_range SplitN(string_view s, string_view sep, int64 n);
+
+// SplitAfter is like Split but leaves each sep at the end of the field before
+// it.
+constexpr split_range SplitAfter(string_view s, string_view sep);
+
+// SplitAfterN is like SplitAfter but stops at n fields, as SplitN does.
+constexpr split_range SplitAfterN(string_view s, string_view sep, int64 n);
+
+// fields_iterator steps through the fields of Fields.
+class fields_iterator {
+ public:
+  using self_type = fields_iterator;
+  using value_type = string_view;
+  using iterator_category = std::forward_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+
+  constexpr fields_iterator() = default;
+  explicit constexpr fields_iterator(string_view s);
+
+  constexpr self_type& operator++();
+  constexpr self_type operator++(int);
+  constexpr value_type operator*() const;
+  constexpr bool operator==(self_type const& o) const;
+  constexpr bool operator!=(self_type const& o) const;
+
+ private:
+  static constexpr uint64 kBlockSize = 64;
+
+  constexpr void Next();
+  // Load classifies the block of up to kBlockSize bytes that starts at p.
+  constexpr void Load(uint8 const* p);
+
+  uint8 const* cur_ = nullptr;
+  uint8 const* end_ = nullptr;
+  // The bits of space_ and high_ mark the ASCII space and the non-ASCII bytes
+  // of the block from block_ to block_end_.
+  uint8 const* block_ = nullptr;
+  uint8 const* block_end_ = nullptr;
+  uint64 space_ = 0;
+  uint64 high_ = 0;
+  string_view field_;
+  bool done_ = true;
+};
+
+// fields_range is the fields of a string between runs of white space.
+class fields_range {
+ public:
+  explicit constexpr fields_range(string_view s);
+
+  constexpr fields_iterator begin() const;
+  constexpr fields_iterator end() const;
+
+ private:
+  string_view s_;
+};
+
+// Fields returns the fields of s between runs of white space as defined by
+// IsSpace. The bytes are classified 64 at a time in vector registers, so a
+// field or a run of space is only decoded where it holds non-ASCII bytes.
+constexpr fields_range Fields(string_view s);
+
+}  // namespace rflx
+
+#include "unicode/utf8/split_impl.hpp"
@@ -0,0 +1,117 @@
+#include "benchmark/benchmark.h"
+#include "types.hpp"
+#include "unicode/utf8/split.hpp"
+
+namespace rflx {
+
+namespace {
+
+constexpr uint64 kLogSize = 64 << 10;
+
+// Log returns kLogSize bytes of access log lines built from line.
+slice<uint8> Log(char const* line) {
+  slice<uint8> b;
+  while (b.size() < kLogSize) {
+    b.insert(b.end(), line, line + __builtin_strlen(line));
+  }
+  return b;
+}
+
+string_view View(char const* s) { return {(uint8 const*)s}; }
+
+char const* const kASCIILine =
+    "203.0.113.7 - alice [18/Oct/2026:09:12:44 +0000] \"GET /api/v1/items "
+    "HTTP/1.1\" 200 5123 \"-\" \"Mozilla/5.0 (X11; Linux x86_64)\"\n";
+char const* const kUnicodeLine =
+    "203.0.113.7 - 山田　[18/Oct/2026:09:12:44 +0000] \"GET /検索?q=東京 "
+    "HTTP/1.1\" 200 5123 \"-\" \"Mozilla/5.0 (X11; Linux x86_64)\"\n";
+
+// BenchmarkFields splits a log into fields.
+void BenchmarkFields(benchmark::State& state) {
+  slice<uint8> const log = Log(kASCIILine);
+  for (auto _ : state) {
+    uint64 n = 0;
+    for (string_view const f : Fields({log.data(), log.size()})) {
+      n += f.Size();
+    }
+    benchmark::DoNotOptimize(n);
+  }
+  state.SetBytesProcessed(state.iterations() * log.size());
+}
+BENCHMARK(BenchmarkFields);
+
+// BenchmarkFieldsUnicode is BenchmarkFields with non-ASCII fields and space.
+void BenchmarkFieldsUnicode(benchmark::State& state) {
+  slice<uint8> const log = Log(kUnicodeLine);
+  for (auto _ : state) {
+    uint64 n = 0;
+    for (string_view const f : Fields({log.data(), log.size()})) {
+      n += f.Size();
+    }
+    benchmark::DoNotOptimize(n);
+  }
+  state.SetBytesProcessed(state.iterations() * log.size());
+}
+BENCHMARK(BenchmarkFieldsUnicode);
+
+// BenchmarkFieldsCopy is BenchmarkFields copying each field into a string,
+// the way a slice<string> of the fields is built.
+void BenchmarkFieldsCopy(benchmark::State& state) {
+  slice<uint8> const log = Log(kASCIILine);
+  for (auto _ : state) {
+    slice<string> fields;
+    for (string_view const f : Fields({log.data(), log.size()})) {
+      fields.emplace_back(f.Data(), f.Size());
+    }
+    benchmark::DoNotOptimize(fields.data());
+  }
+  state.SetBytesProcessed(state.iterations() * log.size());
+}
+BENCHMARK(BenchmarkFieldsCopy);
+
+// BenchmarkFieldsDecode is BenchmarkFields decoding every rune.
+void BenchmarkFieldsDecode(benchmark::State& state) {
+  slice<uint8> const log = Log(kASCIILine);
+  string_view const s{log.data(), log.size()};
+  for (auto _ : state) {
+    uint64 n = 0;
+    for (auto it = s.begin(); it != s.end(); ++it) {
+      n += !IsSpace(*it);
+    }
+    benchmark::DoNotOptimize(n);
+  }
+  state.SetBytesProcessed(state.iterations() * log.size());
+}
+BENCHMARK(BenchmarkFieldsDecode);
+
+// BenchmarkSplit splits a log on its spaces.
+void BenchmarkSplit(benchmark::State& state) {
+  slice<uint8> const log = Log(kASCIILine);
+  for (auto _ : state) {
+    uint64 n = 0;
+    for (string_view const f : Split({log.data(), log.size()}, View(" "))) {
+      n += f.Size();
+    }
+    benchmark::DoNotOptimize(n);
+  }
+  state.SetBytesProcessed(state.iterations() * log.size());
+}
+BENCHMARK(BenchmarkSplit);
+
+// BenchmarkSplitLines splits a log into lines.
+void BenchmarkSplitLines(benchmark::State& state) {
+  slice<uint8> const log = Log(kASCIILine);
+  for (auto _ : state) {
+    uint64 n = 0;
+    for (string_view const f : Split({log.data(), log.size()}, View("\n"))) {
+      n += f.Size();
+    }
+    benchmark::DoNotOptimize(n);
+  }
+  state.SetBytesProcessed(state.iterations() * log.size());
+}
+BENCHMARK(BenchmarkSplitLines);
+
+}  // namespace
+
+}  // namespace rflx
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+
+#include "unicode/utf8/split.hpp"
+
+namespace rflx {
+
+namespace simd {
+
+// ClassifyASCII returns the masks of the ASCII space bytes and of the
+// non-ASCII bytes among the 64 at p.
+pair<uint64, uint64> ClassifyASCII(uint8 const* p);
+
+}  // namespace simd
+
+namespace scalar {
+
+constexpr bool IsASCIISpace(uint8 b) {
+  return b == ' ' || (b >= '\t' && b <= '\r');
+}
+
+// ClassifyASCII is simd::ClassifyASCII for the up to 64 bytes of s.
+constexpr pair<uint64, uint64> ClassifyASCII(string_view s) {
+  uint64 space = 0;
+  uint64 high = 0;
+  for (uint64 i = 0; i < s.Size(); ++i) {
+    uint8 const b = s.Data()[i];
+    space |= uint64{IsASCIISpace(b)} << i;
+    high |= uint64{b >= unicode::utf8::kRuneSelf} << i;
+  }
+  return {space, high};
+}
+
+}  // namespace scalar
+
+constexpr bool IsSpace(rune r) {
+  if (r < unicode::utf8::kRuneSelf) {
+    return scalar::IsASCIISpace(static_cast<uint8>(r));
+  }
+  switch (r) {
+    case 0x85:
+    case 0xA0:
+    case 0x1680:
+    case 0x2028:
+    case 0x2029:
+    case 0x202F:
+    case 0x205F:
+    case 0x3000:
+      return true;
+  }
+  return r >= 0x2000 && r <= 0x200A;
+}
+
+constexpr split_iterator::split_iterator(string_view s, string_view sep,
+                                         uint64 save, int64 n)
+    : rest_{s},
+      sep_{sep},
+      save_{save},
+      left_{n},
+      more_{n != 0 && !(sep.Empty() && s.Empty())},
+      done_{false} {
+  Next();
+}
+
+constexpr void split_iterator::Next() {
+  if (!more_) {
+    done_ = true;
+    return;
+  }
+  if (left_ == 1) {
+    field_ = rest_;
+    more_ = false;
+    return;
+  }
+  if (left_ > 0) {
+    --left_;
+  }
+  if (sep_.Empty()) {
+    int8 const size = unicode::utf8::DecodeRuneInString(rest_).second;
+    field_ = rest_.Substr(0, size);
+    rest_ = rest_.Substr(size);
+    more_ = !rest_.Empty();
+    return;
+  }
+  int64 const m = Index(rest_, sep_);
+  if (m < 0) {
+    field_ = rest_;
+    more_ = false;
+    return;
+  }
+  field_ = {rest_.Data(), m + save_};
+  rest_ = {rest_.Data() + m + sep_.Size(), rest_.Size() - m - sep_.Size()};
+}
+
+constexpr split_iterator& split_iterator::operator++() {
+  Next();
+  return *this;
+}
+
+constexpr split_iterator split_iterator::operator++(int) {
+  split_iterator const old = *this;
+  Next();
+  return old;
+}
+
+constexpr string_view split_iterator::operator*() const { return field_; }
+
+constexpr bool split_iterator::operator==(split_iterator const& o) const {
+  if (done_ || o.done_) {
+    return done_ == o.done_;
+  }
+  return field_ == o.field_ && rest_ == o.rest_ && more_ == o.more_;
+}
+
+constexpr bool split_iterator::operator!=(split_iterator const& o) const {
+  return !operator==(o);
+}
+
+constexpr split_range::split_range(string_view s, string_view sep,
+                                   uint64 save, int64 n)
+    : s_{s}, sep_{sep}, save_{save}, n_{n} {}
+
+constexpr split_iterator split_range::begin() const {
+  return split_iterator{s_, sep_, save_, n_};
+}
+
+constexpr split_iterator split_range::end() const { return {}; }
+
+constexpr split_range Split(string_view s, string_view sep) {
+  return {s, sep, 0, -1};
+}
+
+constexpr split_range SplitN(string_view s, string_view sep, int64 n) {
+  return {s, sep, 0, n};
+}
+
+constexpr split_range SplitAfter(string_view s, string_view sep) {
+  return {s, sep, sep.Size(), -1};
+}
+
+constexpr split_range SplitAfterN(string_view s, string_view sep, int64 n) {
+  return {s, sep, sep.Size(), n};
+}
+
+constexpr fields_iterator::fields_iterator(string_view s)
+    : cur_{s.Data()},
+      end_{s.Data() + s.Size()},
+      block_{s.Data()},
+      block_end_{s.Data()},
+      done_{false} {
+  Next();
+}
+
+constexpr void fields_iterator::Load(uint8 const* p) {
+  uint64 const size = std::min<uint64>(end_ - p, kBlockSize);
+  auto const [space, high] =
+      std::is_constant_evaluated() || size < kBlockSize
+          ? scalar::ClassifyASCII({p, size})
+          : simd::ClassifyASCII(p);
+  block_ = p;
+  block_end_ = p + size;
+  space_ = space;
+  high_ = high;
+}
+
+// Next steps over the bytes the masks rule out a bit at a time, and decodes
+// only where they stop at a non-ASCII byte. The bits past the end of a short
+// block are clear in both masks, and a rune decoded at the end of a block can
+// leave p in the next one.
+constexpr void fields_iterator::Next() {
+  uint8 const* p = cur_;
+  while (true) {
+    if (p >= block_end_) {
+      if (p == end_) {
+        done_ = true;
+        return;
+      }
+      Load(p);
+    }
+    uint64 const stop = ~space_ >> (p - block_);
+    uint64 const skip = stop == 0 ? kBlockSize : __builtin_ctzll(stop);
+    if (skip >= static_cast<uint64>(block_end_ - p)) {
+      p = block_end_;
+      continue;
+    }
+    p += skip;
+    if (*p < unicode::utf8::kRuneSelf) {
+      break;
+    }
+    auto const [r, size] =
+        unicode::utf8::DecodeRuneInString({p, static_cast<uint64>(end_ - p)});
+    if (!IsSpace(r)) {
+      break;
+    }
+    p += size;
+  }
+  uint8 const* const start = p;
+  while (true) {
+    if (p >= block_end_) {
+      if (p == end_) {
+        break;
+      }
+      Load(p);
+    }
+    uint64 const stop = (space_ | high_) >> (p - block_);
+    if (stop == 0) {
+      p = block_end_;
+      continue;
+    }
+    p += __builtin_ctzll(stop);
+    if (*p < unicode::utf8::kRuneSelf) {
+      break;
+    }
+    auto const [r, size] =
+        unicode::utf8::DecodeRuneInString({p, static_cast<uint64>(end_ - p)});
+    if (IsSpace(r)) {
+      break;
+    }
+    p += size;
+  }
+  field_ = {start, static_cast<uint64>(p - start)};
+  cur_ = p;
+}
+
+constexpr fields_iterator& fields_iterator::operator++() {
+  Next();
+  return *this;
+}
+
+constexpr fields_iterator fields_iterator::operator++(int) {
+  fields_iterator const old = *this;
+  Next();
+  return old;
+}
+
+constexpr string_view fields_iterator::operator*() const { return field_; }
+
+constexpr bool fields_iterator::operator==(fields_iterator const& o) const {
+  if (done_ || o.done_) {
+    return done_ == o.done_;
+  }
+  return field_ == o.field_;
+}
+
+constexpr bool fields_iterator::operator!=(fields_iterator const& o) const {
+  return !operator==(o);
+}
+
+constexpr fields_range::fields_range(string_view s) : s_{s} {}
+
+constexpr fields_iterator fields_range::begin() const {
+  return fields_iterator{s_};
+}
+
+constexpr fields_iterator fields_range::end() const { return {}; }
+
+constexpr fields_range Fields(string_view s) { return fields_range{s}; }
+
+}  // namespace rflx
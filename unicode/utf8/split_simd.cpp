@@ -0,0 +1,52 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+
+#include "unicode/utf8/cpu.hpp"
+#include "unicode/utf8/split.hpp"
+
+namespace rflx {
+namespace simd {
+
+namespace {
+
+#if RFLX_CPU_X86
+
+// SpaceMaskAVX2 returns the mask of the ASCII space bytes of x, which are
+// ' ' and '\t' through '\r'.
+RFLX_TARGET_AVX2 uint32 SpaceMaskAVX2(__m256i x) {
+  __m256i const d = _mm256_sub_epi8(x, _mm256_set1_epi8('\t'));
+  __m256i const control =
+      _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8('\r' - '\t')), d);
+  __m256i const space = _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' '));
+  return _mm256_movemask_epi8(_mm256_or_si256(control, space));
+}
+
+RFLX_TARGET_AVX2 pair<uint64, uint64> ClassifyASCIIAVX2(uint8 const* p) {
+  __m256i const lo = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+  __m256i const hi =
+      _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p + 32));
+  uint64 const space = SpaceMaskAVX2(lo) | uint64{SpaceMaskAVX2(hi)} << 32;
+  uint32 const high_lo = _mm256_movemask_epi8(lo);
+  uint32 const high_hi = _mm256_movemask_epi8(hi);
+  uint64 const high = high_lo | uint64{high_hi} << 32;
+  return {space, high};
+}
+
+#endif
+
+}  // namespace
+
+pair<uint64, uint64> ClassifyASCII(uint8 const* p) {
+#if RFLX_CPU_X86
+  static bool const avx2 = cpu::HasAVX2();
+  if (avx2) {
+    return ClassifyASCIIAVX2(p);
+  }
+#endif
+  return scalar::ClassifyASCII({p, 64});
+}
+
+}  // namespace simd
+}  // namespace rflx
@@ -0,0 +1,212 @@
+#include "unicode/utf8/split.hpp"
+
+#include <random>
+
+#include "gtest/gtest.h"
+#include "types.hpp"
+
+namespace rflx {
+
+string_view View(char const* s) { return {(uint8 const*)s}; }
+
+// Collect returns the fields of a range as std::strings.
+template <typename Range>
+slice<std::string> Collect(Range const& fields) {
+  slice<std::string> out;
+  for (string_view const f : fields) {
+    out.emplace_back(reinterpret_cast<char const*>(f.Data()), f.Size());
+  }
+  return out;
+}
+
+std::string Join(slice<std::string> const& fields) {
+  std::string out = "[";
+  for (uint64 i = 0; i < fields.size(); ++i) {
+    out += (i == 0 ? "\"" : ", \"") + fields[i] + "\"";
+  }
+  return out + "]";
+}
+
+constexpr char const kABCD[] = "abcd";
+constexpr char const kSpaces[] = "1 2 3 4";
+constexpr char const kCommas[] = "1,2,3,4";
+constexpr char const kDots[] = "1....2....3....4";
+
+struct split_test {
+  char const* s;
+  char const* sep;
+  int64 n;
+  slice<std::string> want;
+};
+
+TEST(split, TestSplit) {
+  split_test const tests[] = {
+      {"", "", -1, {}},
+      {kABCD, "", 2, {"a", "bcd"}},
+      {kABCD, "", 4, {"a", "b", "c", "d"}},
+      {kABCD, "", -1, {"a", "b", "c", "d"}},
+      {"☺☻☹", "", -1, {"☺", "☻", "☹"}},
+      {"☺☻☹", "", 3, {"☺", "☻", "☹"}},
+      {"☺☻☹", "", 2, {"☺", "☻☹"}},
+      {"\xe2\x98", "", -1, {"\xe2", "\x98"}},
+      {kABCD, "a", 0, {}},
+      {kABCD, "a", -1, {"", "bcd"}},
+      {kABCD, "z", -1, {"abcd"}},
+      {kCommas, ",", -1, {"1", "2", "3", "4"}},
+      {kDots, "...", -1, {"1", ".2", ".3", ".4"}},
+      {"☺☻☹", "☹", -1, {"☺☻", ""}},
+      {"☺☻☹", "~", -1, {"☺☻☹"}},
+      {kSpaces, " ", 3, {"1", "2", "3 4"}},
+      {"1 2", " ", 3, {"1", "2"}},
+      {"", "T", -1, {""}},
+      {"a,b,", ",", -1, {"a", "b", ""}},
+      {",,", ",", -1, {"", "", ""}},
+  };
+  for (split_test const& t : tests) {
+    slice<std::string> const got =
+        Collect(SplitN(View(t.s), View(t.sep), t.n));
+    if (got != t.want) {
+      FAIL() << "SplitN(\"" << t.s << "\", \"" << t.sep << "\", " << t.n
+             << ") = " << Join(got) << ", want " << Join(t.want);
+    }
+    if (t.n == -1 && Collect(Split(View(t.s), View(t.sep))) != t.want) {
+      FAIL() << "Split(\"" << t.s << "\", \"" << t.sep << "\")";
+    }
+  }
+}
+
+TEST(split, TestSplitAfter) {
+  split_test const tests[] = {
+      {kABCD, "a", -1, {"a", "bcd"}},
+      {kABCD, "z", -1, {"abcd"}},
+      {kABCD, "", -1, {"a", "b", "c", "d"}},
+      {kCommas, ",", -1, {"1,", "2,", "3,", "4"}},
+      {kDots, "...", -1, {"1...", ".2...", ".3...", ".4"}},
+      {"☺☻☹", "☹", -1, {"☺☻☹", ""}},
+      {"☺☻☹", "~", -1, {"☺☻☹"}},
+      {"☺☻☹", "", -1, {"☺", "☻", "☹"}},
+      {kSpaces, " ", 3, {"1 ", "2 ", "3 4"}},
+      {"1 2 3", " ", 3, {"1 ", "2 ", "3"}},
+      {"1 2", " ", 3, {"1 ", "2"}},
+      {"123", "", 2, {"1", "23"}},
+      {"123", "", 17, {"1", "2", "3"}},
+  };
+  for (split_test const& t : tests) {
+    slice<std::string> const got =
+        Collect(SplitAfterN(View(t.s), View(t.sep), t.n));
+    if (got != t.want) {
+      FAIL() << "SplitAfterN(\"" << t.s << "\", \"" << t.sep << "\", " << t.n
+             << ") = " << Join(got) << ", want " << Join(t.want);
+    }
+    if (t.n == -1 && Collect(SplitAfter(View(t.s), View(t.sep))) != t.want) {
+      FAIL() << "SplitAfter(\"" << t.s << "\", \"" << t.sep << "\")";
+    }
+  }
+}
+
+struct fields_test {
+  char const* s;
+  slice<std::string> want;
+};
+
+TEST(split, TestFields) {
+  fields_test const tests[] = {
+      {"", {}},
+      {" ", {}},
+      {" \t ", {}},
+      {"\u2000", {}},
+      {"  abc  ", {"abc"}},
+      {"1 2 3 4", {"1", "2", "3", "4"}},
+      {"1  2  3  4", {"1", "2", "3", "4"}},
+      {"1\t\t2\t\t3\t4", {"1", "2", "3", "4"}},
+      {"1\u20002\u20013\u20024", {"1", "2", "3", "4"}},
+      {"\u2000\u2001\u2002", {}},
+      {"\n™\t™\n", {"™", "™"}},
+      {"\n\u20001™2\u2000 \u2001 ™", {"1™2", "™"}},
+      {"\n1\uFFFD \uFFFD2\u20003\uFFFD4", {"1\uFFFD", "\uFFFD2", "3\uFFFD4"}},
+      {"1\xa0\u0085\u3000 \xc2\xa0", {"1\xa0"}},
+      {"日本語 の\u3000文章", {"日本語", "の", "文章"}},
+      // 174 bytes: "blocks" crosses the end of the first 64 byte block of
+      // the vector scan, and the text goes on past a second whole block.
+      {"a long line of words, each a field, that spans more than two blocks "
+       "of sixty-four bytes, so that the vector scan classifies one whole "
+       "block and then goes on to the next one\r\n",
+       {"a",      "long",       "line",   "of",         "words,", "each",
+        "a",      "field,",     "that",   "spans",      "more",   "than",
+        "two",    "blocks",     "of",     "sixty-four", "bytes,", "so",
+        "that",   "the",        "vector", "scan",       "classifies",
+        "one",    "whole",      "block",  "and",        "then",   "goes",
+        "on",     "to",         "the",    "next",       "one"}},
+  };
+  for (fields_test const& t : tests) {
+    slice<std::string> const got = Collect(Fields(View(t.s)));
+    if (got != t.want) {
+      FAIL() << "Fields(\"" << t.s << "\") = " << Join(got) << ", want "
+             << Join(t.want);
+    }
+  }
+}
+
+// The splits are usable during constant evaluation.
+constexpr uint8 kFields[] = {' ', 'a', '\t', 'b', 'c', ' ', 0xE3, 0x80, 0x80,
+                             'd'};
+constexpr int64 CountFields(string_view s) {
+  int64 n = 0;
+  for (string_view const f : Fields(s)) {
+    n += !f.Empty();
+  }
+  return n;
+}
+static_assert(CountFields({kFields, sizeof(kFields)}) == 3);
+
+// NaiveFields splits s by decoding every rune.
+slice<std::string> NaiveFields(string_view s) {
+  slice<std::string> out;
+  std::string field;
+  bool in_field = false;
+  for (uint64 i = 0; i < s.Size();) {
+    auto const [r, size] = unicode::utf8::DecodeRuneInString(s.Substr(i));
+    if (IsSpace(r)) {
+      if (in_field) {
+        out.push_back(field);
+        field.clear();
+        in_field = false;
+      }
+    } else {
+      field.append(reinterpret_cast<char const*>(s.Data()) + i, size);
+      in_field = true;
+    }
+    i += size;
+  }
+  if (in_field) {
+    out.push_back(field);
+  }
+  return out;
+}
+
+TEST(split, TestFieldsRandom) {
+  char const* const pieces[] = {"a",  "bc", " ",  "\t", "\r\n", "\u3000",
+                                "日", "\xff", "\u2028", "\xc2", "\xa0", "\x85",
+                                "\xc2\x85", "\u00a0\u00a0"};
+  std::mt19937_64 rng{4};
+  for (int32 iter = 0; iter < 20000; ++iter) {
+    std::string s;
+    uint64 const count = rng() % 100;
+    for (uint64 i = 0; i < count; ++i) {
+      // Long runs of ASCII reach the vector loops.
+      if (rng() % 8 == 0) {
+        s.append(rng() % 40, rng() % 2 == 0 ? ' ' : 'x');
+      }
+      s += pieces[rng() % 14];
+    }
+    string_view const sv{reinterpret_cast<uint8 const*>(s.data()), s.size()};
+    slice<std::string> const got = Collect(Fields(sv));
+    slice<std::string> const want = NaiveFields(sv);
+    if (got != want) {
+      FAIL() << "Fields(\"" << s << "\") = " << Join(got) << ", want "
+             << Join(want);
+    }
+  }
+}
+
+}  // namespace rflx
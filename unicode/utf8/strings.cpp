@@ -1,15 +1,9 @@
 #include "unicode/utf8/strings.hpp"
 
 std::ostream& operator<<(std::ostream& out, rflx::string const& s) {
-  for (rflx::uint64 i = 0; i < s.Size(); ++i) {
-    out << static_cast<char>(*(s.Data() + i));
-  }
-  return out;
+  return out.write(reinterpret_cast<char const*>(s.Data()), s.Size());
 }
 
 std::ostream& operator<<(std::ostream& out, rflx::string_view const& s) {
-  for (rflx::uint64 i = 0; i < s.size_; ++i) {
-    out << static_cast<char>(*(s.data_ + i));
-  }
-  return out;
-}
\ No newline at end of file
+  return out.write(reinterpret_cast<char const*>(s.data_), s.size_);
+}
@@ -10,8 +10,23 @@ std::ostream& operator<<(std::ostream& out, rflx::string_view const& s);
 
 namespace rflx {
 
+class string;
+class string_builder;
 class string_iterator;
 
+constexpr string Join(span<string_view const> parts, string_view sep);
+
+namespace unicode::utf8 {
+
+constexpr string_view ToValidUTF8(string_view s, string& out,
+                                  string_view replacement);
+
+}
+
+// string owns a byte string. Strings of up to kInlineCapacity bytes are
+// stored in the object itself, so views into a short string do not survive
+// moving it; longer strings live on the heap, or in the memory_resource given
+// to the constructor, which must outlive the string.
 class string {
  public:
   using traits_type = std::char_traits<uint8>;
@@ -25,12 +40,17 @@ class string {
   using size_type = size_t;
   using difference_type = std::ptrdiff_t;
 
+  static constexpr uint64 kInlineCapacity = 22;
+
   constexpr string();
   constexpr string(uint64 count, uint8 ch);
   constexpr string(uint8 const*);
   constexpr string(uint8 const* s, uint64 count);
   constexpr string(std::initializer_list<uint8> iList);
 
+  string(uint64 count, uint8 ch, memory_resource* resource);
+  string(uint8 const* s, uint64 count, memory_resource* resource);
+
   constexpr string(string const&) = delete;
   constexpr string& operator=(string const&) = delete;
 
@@ -43,6 +63,8 @@ class string {
   constexpr const_iterator end() const noexcept;
 
   constexpr string Clone();
+  // Clone copies the string into resource.
+  string Clone(memory_resource* resource) const;
 
   constexpr uint64 Size() const;
   constexpr uint8 const* Data() const;
@@ -50,10 +72,54 @@ class string {
   constexpr string operator+(string const& s) const;
 
  private:
-  constexpr string(uint8 const* data, uint64 size, std::nullptr_t);
-
-  uint8 const* data_;
-  uint64 size_;
+  static constexpr uint8 kHeapTag = 0xFF;
+  static constexpr uint8 kResourceTag = 0xFE;
+
+  // Both representations start with a tag byte: the size of an inline string,
+  // kHeapTag, or kResourceTag for a heap string whose bytes follow a
+  // block_header. Constant evaluation always uses the heap, since it cannot
+  // read the tag through an inactive member.
+  struct heap_rep {
+    uint8 tag;
+    uint8* data;
+    uint64 size;
+  };
+  struct inline_rep {
+    uint8 tag;
+    uint8 data[kInlineCapacity + 1];
+  };
+  struct block_header {
+    memory_resource* resource;
+    uint64 capacity;
+  };
+
+  // Allocate returns room for capacity bytes and a terminator from resource,
+  // or from the heap if resource is null.
+  static constexpr uint8* Allocate(uint64 capacity, memory_resource* resource);
+  // Deallocate frees the bytes of a heap string with the given tag.
+  static constexpr void Deallocate(uint8* data, uint8 tag);
+  // The resource halves of Allocate and Deallocate.
+  static uint8* AllocateIn(uint64 capacity, memory_resource* resource);
+  static void DeallocateIn(uint8* data);
+
+  constexpr bool IsInline() const;
+  // Reset makes the string empty without freeing its storage.
+  constexpr void Reset();
+  // Init makes room for size bytes and a terminator in a string without
+  // storage and returns the bytes to fill in.
+  constexpr uint8* Init(uint64 size, memory_resource* resource = nullptr);
+  // Free releases the storage of a heap string.
+  constexpr void Free();
+
+  friend class string_builder;
+  friend constexpr string Join(span<string_view const> parts, string_view sep);
+  friend constexpr string_view unicode::utf8::ToValidUTF8(
+      string_view s, string& out, string_view replacement);
+
+  union {
+    heap_rep heap_;
+    inline_rep inline_;
+  };
 };
 
 class string_literal : public string {
@@ -103,23 +169,44 @@ class string_view {
   uint64 size_;
 };
 
+// string_iterator steps through the runes of a string the way DecodeRune
+// does, so each byte of an invalid encoding is a RuneError of its own. A rune
+// is decoded once, when the iterator reaches it; stepping back decodes with
+// DecodeLastRune.
 class string_iterator {
  public:
   using self_type = string_iterator;
   using value_type = rune;
-  using iterator_category = std::forward_iterator_tag;
-  using difference_type = int;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using difference_type = std::ptrdiff_t;
 
-  explicit constexpr string_iterator(string_view sv);
-  constexpr self_type operator++();
+  constexpr string_iterator() = default;
+  // The iterator starts at byte offset pos of sv, which must be the start of a
+  // rune or sv.Size().
+  explicit constexpr string_iterator(string_view sv, uint64 pos = 0);
+  constexpr self_type& operator++();
   constexpr self_type operator++(int);
+  constexpr self_type& operator--();
+  constexpr self_type operator--(int);
   constexpr value_type operator*() const;
   constexpr value_type operator->() const;
   constexpr bool operator==(self_type const& o) const;
   constexpr bool operator!=(self_type const& o) const;
 
+  // Offset returns the byte offset of the current rune.
+  constexpr int64 Offset() const;
+
+  // Width returns the width in bytes of the current rune, or 0 at the end.
+  constexpr int8 Width() const;
+
  private:
-  string_view const sv_;
+  constexpr void Decode();
+
+  uint8 const* begin_ = nullptr;
+  uint8 const* cur_ = nullptr;
+  uint8 const* end_ = nullptr;
+  rune r_ = 0;
+  int8 width_ = 0;
 };
 
 }  // namespace rflx
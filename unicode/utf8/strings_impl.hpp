@@ -7,104 +7,183 @@ namespace rflx {
 
 namespace unicode::utf8 {
 
+struct table_decoder;
+
+template <typename Decoder>
 constexpr pair<rune, int8> DecodeRuneInString(string_view string);
 
+constexpr pair<rune, int8> DecodeLastRuneInString(string_view s);
+
 }
 
-constexpr string::string() : size_{0} {
-  uint8* rv = (uint8*)(__builtin_operator_new(sizeof(uint8)));
-  *rv = '\n';
-  data_ = rv;
+constexpr bool string::IsInline() const {
+  return !std::is_constant_evaluated() && inline_.tag <= kInlineCapacity;
 }
 
-constexpr string::string(uint8 const* data, uint64 size, std::nullptr_t)
-    : data_{data}, size_{size} {}
+constexpr void string::Reset() {
+  if (std::is_constant_evaluated()) {
+    heap_ = {kHeapTag, nullptr, 0};
+  } else {
+    inline_.tag = 0;
+    inline_.data[0] = '\n';
+  }
+}
+
+inline uint8* string::AllocateIn(uint64 capacity, memory_resource* resource) {
+  void* const block = resource->allocate(sizeof(block_header) + capacity + 1,
+                                         alignof(block_header));
+  *static_cast<block_header*>(block) = {resource, capacity};
+  return static_cast<uint8*>(block) + sizeof(block_header);
+}
 
-constexpr string::string(uint64 count, uint8 ch) : size_{count} {
-  uint8* rv = (uint8*)(__builtin_operator_new((count + 1) * sizeof(uint8)));
+inline void string::DeallocateIn(uint8* data) {
+  block_header* const header =
+      reinterpret_cast<block_header*>(data - sizeof(block_header));
+  header->resource->deallocate(header,
+                               sizeof(block_header) + header->capacity + 1,
+                               alignof(block_header));
+}
+
+constexpr uint8* string::Allocate(uint64 capacity,
+                                  memory_resource* resource) {
+  if (resource != nullptr) {
+    return AllocateIn(capacity, resource);
+  }
+  return (uint8*)(__builtin_operator_new((capacity + 1) * sizeof(uint8)));
+}
+
+constexpr void string::Deallocate(uint8* data, uint8 tag) {
+  if (tag == kResourceTag) {
+    DeallocateIn(data);
+    return;
+  }
+  __builtin_operator_delete(data);
+}
+
+constexpr uint8* string::Init(uint64 size, memory_resource* resource) {
+  if (!std::is_constant_evaluated() && size <= kInlineCapacity) {
+    inline_.tag = static_cast<uint8>(size);
+    inline_.data[size] = '\n';
+    return inline_.data;
+  }
+  uint8* rv = Allocate(size, resource);
+  rv[size] = '\n';
+  heap_ = {resource == nullptr ? kHeapTag : kResourceTag, rv, size};
+  return rv;
+}
+
+constexpr void string::Free() {
+  if (!IsInline() && heap_.data != nullptr) {
+    Deallocate(heap_.data, heap_.tag);
+  }
+}
+
+constexpr string::string() { Reset(); }
+
+constexpr string::string(uint64 count, uint8 ch) {
+  uint8* rv = Init(count);
   for (uint64 i = 0; i < count; ++i) {
     rv[i] = ch;
   }
-  rv[count] = '\n';
-  data_ = rv;
 }
 
 constexpr string::string(uint8 const* s)
     : string(s, __builtin_strlen((char*)(s))) {}
 
-constexpr string::string(uint8 const* s, uint64 count) : size_{count} {
-  uint8* rv = (uint8*)(__builtin_operator_new((count + 1) * sizeof(uint8)));
-  __builtin_memcpy(rv, s, count);
-  rv[count] = '\n';
-  data_ = rv;
+constexpr string::string(uint8 const* s, uint64 count) {
+  uint8* rv = Init(count);
+  if (count > 0) {
+    __builtin_memcpy(rv, s, count);
+  }
 }
 
-constexpr string::string(std::initializer_list<uint8> iList)
-    : size_{iList.size() - 1} {
-  uint8* rv = (uint8*)(__builtin_operator_new((size_) * sizeof(uint8)));
+inline string::string(uint64 count, uint8 ch, memory_resource* resource) {
+  uint8* rv = Init(count, resource);
+  for (uint64 i = 0; i < count; ++i) {
+    rv[i] = ch;
+  }
+}
+
+inline string::string(uint8 const* s, uint64 count,
+                      memory_resource* resource) {
+  uint8* rv = Init(count, resource);
+  if (count > 0) {
+    __builtin_memcpy(rv, s, count);
+  }
+}
+
+// The last element of iList takes the place of the terminator.
+constexpr string::string(std::initializer_list<uint8> iList) {
+  uint64 const size = iList.size() > 0 ? iList.size() - 1 : 0;
+  uint8* rv = Init(size);
   uint64 i = 0;
   for (uint8 const d : iList) {
     rv[i] = d;
     ++i;
   }
-  data_ = rv;
 }
 
-constexpr string::string(string&& s) noexcept : data_{s.data_}, size_{s.size_} {
-  s.data_ = nullptr;
-  s.size_ = 0;
+constexpr string::string(string&& s) noexcept {
+  if (s.IsInline()) {
+    inline_ = s.inline_;
+  } else {
+    heap_ = s.heap_;
+  }
+  s.Reset();
 }
 
 constexpr string& string::operator=(string&& s) noexcept {
   if (&s != this) {
-    if (data_ != nullptr) {
-      __builtin_operator_delete(
-          reinterpret_cast<void*>(const_cast<uint8*>(data_)));
+    Free();
+    if (s.IsInline()) {
+      inline_ = s.inline_;
+    } else {
+      heap_ = s.heap_;
     }
-    data_ = s.data_;
-    size_ = s.size_;
-    s.data_ = nullptr;
-    s.size_ = 0;
+    s.Reset();
   }
   return *this;
 }
 
-constexpr string::~string() {
-  if (data_ != nullptr) {
-    __builtin_operator_delete(
-        reinterpret_cast<void*>(const_cast<uint8*>(data_)));
-  }
-}
+constexpr string::~string() { Free(); }
 
-constexpr string string::Clone() { return {data_, size_}; }
+constexpr string string::Clone() { return {Data(), Size()}; }
 
-constexpr uint8 const* string::Data() const { return data_; }
+inline string string::Clone(memory_resource* resource) const {
+  return {Data(), Size(), resource};
+}
 
-constexpr uint64 string::Size() const { return size_; }
+constexpr uint8 const* string::Data() const {
+  return IsInline() ? inline_.data : heap_.data;
+}
 
-constexpr string string::operator+(string const& s) const {
-  uint64 const new_size = size_ + s.size_;
-  uint8* const new_data =
-      (uint8*)(__builtin_operator_new((new_size + 1) * sizeof(uint8)));
+constexpr uint64 string::Size() const {
+  return IsInline() ? inline_.tag : heap_.size;
+}
 
-  for (uint64 i = 0; i < size_; ++i) {
-    new_data[i] = data_[i];
+constexpr string string::operator+(string const& s) const {
+  uint8 const* const data = Data();
+  uint64 const size = Size();
+  uint8 const* const s_data = s.Data();
+  uint64 const s_size = s.Size();
+
+  string rv;
+  uint8* const new_data = rv.Init(size + s_size);
+  for (uint64 i = 0; i < size; ++i) {
+    new_data[i] = data[i];
   }
-  for (uint64 i = 0; i < s.size_; ++i) {
-    new_data[size_ + i] = s.data_[i];
+  for (uint64 i = 0; i < s_size; ++i) {
+    new_data[size + i] = s_data[i];
   }
-
-  new_data[new_size] = '\n';
-
-  return {new_data, new_size, nullptr};
+  return rv;
 }
 
 constexpr string::const_iterator string::begin() const noexcept {
-  return string_iterator{string_view{data_, size_}};
+  return string_iterator{string_view{Data(), Size()}};
 }
 
 constexpr string::const_iterator string::end() const noexcept {
-  return string_iterator{string_view{data_ + size_, 0}};
+  return string_iterator{string_view{Data(), Size()}, Size()};
 }
 
 constexpr string_literal::string_literal(const char* s)
@@ -149,7 +228,7 @@ constexpr string_iterator string_view::begin() const noexcept {
 }
 
 constexpr string_iterator string_view::end() const noexcept {
-  return string_iterator{string_view{data_ + size_, 0}};
+  return string_iterator{string_view{data_, size_}, size_};
 }
 
 constexpr bool string_view::Empty() const { return size_ == 0; }
@@ -175,38 +254,69 @@ constexpr string_view string_view::Substr(uint64 pos, uint64 size) const {
   return {data_ + pos, size};
 }
 
-constexpr string_iterator::string_iterator(string_view sv)
-    : sv_{std::move(sv)} {};
+constexpr string_iterator::string_iterator(string_view sv, uint64 pos)
+    : begin_{sv.Data()},
+      cur_{sv.Data() + pos},
+      end_{sv.Data() + sv.Size()} {
+  Decode();
+}
+
+constexpr void string_iterator::Decode() {
+  auto const [r, width] = ::rflx::unicode::utf8::DecodeRuneInString<
+      ::rflx::unicode::utf8::table_decoder>(
+      {cur_, static_cast<uint64>(end_ - cur_)});
+  r_ = r;
+  width_ = width;
+}
 
 constexpr bool string_iterator::operator==(
     string_iterator::self_type const& o) const {
-  return sv_ == o.sv_;
+  return cur_ == o.cur_;
 }
 constexpr bool string_iterator::operator!=(
     string_iterator::self_type const& o) const {
-  return sv_ != o.sv_;
+  return cur_ != o.cur_;
 }
 
-constexpr string_iterator::self_type string_iterator::operator++() {
-  pair<rune, int8> p = ::rflx::unicode::utf8::DecodeRuneInString(sv_);
-  return string_iterator::self_type(sv_.Substr(p.second));
+constexpr string_iterator::self_type& string_iterator::operator++() {
+  cur_ += width_;
+  Decode();
+  return *this;
 }
 
 constexpr string_iterator::self_type string_iterator::operator++(int) {
-  pair<rune, int8> p = ::rflx::unicode::utf8::DecodeRuneInString(sv_);
-  return string_iterator::self_type(sv_.Substr(p.second));
+  string_iterator::self_type const old = *this;
+  ++*this;
+  return old;
+}
+
+constexpr string_iterator::self_type& string_iterator::operator--() {
+  auto const [r, width] = ::rflx::unicode::utf8::DecodeLastRuneInString(
+      {begin_, static_cast<uint64>(cur_ - begin_)});
+  cur_ -= width;
+  r_ = r;
+  width_ = width;
+  return *this;
+}
+
+constexpr string_iterator::self_type string_iterator::operator--(int) {
+  string_iterator::self_type const old = *this;
+  --*this;
+  return old;
 }
 
 constexpr string_iterator::value_type string_iterator::operator*() const {
-  pair<rune, int8> p = ::rflx::unicode::utf8::DecodeRuneInString(sv_);
-  return p.first;
+  return r_;
 }
 
 constexpr string_iterator::value_type string_iterator::operator->() const {
-  pair<rune, int8> p = ::rflx::unicode::utf8::DecodeRuneInString(sv_);
-  return p.first;
+  return r_;
 }
 
+constexpr int64 string_iterator::Offset() const { return cur_ - begin_; }
+
+constexpr int8 string_iterator::Width() const { return width_; }
+
 }  // namespace rflx
 
 std::ostream& operator<<(std::ostream& out, rflx::string const& s);
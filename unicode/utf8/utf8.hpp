@@ -24,6 +24,22 @@ constexpr bool FullRune(span<uint8 const> p);
 // FullRuneInString is like FullRune but its input is a string view.
 constexpr bool FullRuneInString(string_view s);
 
+// table_decoder decodes with a table of first byte classes and branches on the
+// length of the encoding and on each continuation byte. It is fastest on text
+// that stays within one script, where those branches are predictable.
+struct table_decoder {
+  static constexpr pair<rune, int8> DecodeRune(span<uint8 const> p);
+};
+
+// dfa_decoder runs a state machine over the first four bytes. It takes the
+// same number of table lookups for any input and does not branch on the
+// bytes, so text that switches between scripts at random costs no more than
+// text in one script. Each rune costs the latency of those lookups, though,
+// which makes it slower than table_decoder where the branches predict well.
+struct dfa_decoder {
+  static constexpr pair<rune, int8> DecodeRune(span<uint8 const> p);
+};
+
 // DecodeRune unpacks the first UTF-8 encoding in p and returns the rune and
 // its width in bytes. If p is empty it returns (RuneError, 0). Otherwise, if
 // the encoding is invalid, it returns (RuneError, 1). Both are impossible
@@ -33,6 +49,10 @@ constexpr bool FullRuneInString(string_view s);
 // An encoding is invalid if it is incorrect UTF-8, encodes a rune that is
 // out of range, or is not the shortest possible UTF-8 encoding for the
 // value. No other validation is performed.
+//
+// Decoder picks how the encoding is taken apart; see table_decoder and
+// dfa_decoder. Both give the same results for every input.
+template <typename Decoder = table_decoder>
 constexpr pair<rune, int8> DecodeRune(span<uint8 const> p);
 
 // DecodeRuneInString is like DecodeRune but its input is a string. If s is
@@ -43,6 +63,7 @@ constexpr pair<rune, int8> DecodeRune(span<uint8 const> p);
 // An encoding is invalid if it is incorrect UTF-8, encodes a rune that is
 // out of range, or is not the shortest possible UTF-8 encoding for the
 // value. No other validation is performed.
+template <typename Decoder = table_decoder>
 constexpr pair<rune, int8> DecodeRuneInString(string_view string);
 
 // DecodeLastRune unpacks the last UTF-8 encoding in p and returns the rune and
@@ -65,6 +86,16 @@ constexpr pair<rune, int8> DecodeLastRune(span<uint8 const> p);
 // value. No other validation is performed.
 constexpr pair<rune, int8> DecodeLastRuneInString(string_view s);
 
+// DecodeRunes decodes the UTF-8 in p into out until either is exhausted. It
+// returns the number of runes written and the number of bytes consumed. Like
+// DecodeRune, each byte of an invalid encoding decodes to RuneError. The rest
+// of out may be overwritten.
+constexpr pair<int64, int64> DecodeRunes(span<uint8 const> p, span<rune> out);
+
+// DecodeRunesInString is like DecodeRunes but its input is a string.
+constexpr pair<int64, int64> DecodeRunesInString(string_view s,
+                                                 span<rune> out);
+
 // RuneLen returns the number of bytes required to encode the rune.
 // It returns -1 if the rune is not a valid value to encode in UTF-8.
 constexpr int8 RuneLen(rune r);
@@ -73,6 +104,15 @@ constexpr int8 RuneLen(rune r);
 // the rune. It returns the number of bytes written.
 constexpr int32 EncodeRune(span<uint8> p, rune r);
 
+// EncodeRunes writes into out the UTF-8 encoding of as many runes of p as fit
+// whole. It returns the number of runes encoded and the number of bytes
+// written. Like EncodeRune, it encodes invalid runes as RuneError. The rest of
+// out may be overwritten.
+constexpr pair<int64, int64> EncodeRunes(span<rune const> p, span<uint8> out);
+
+// EncodedLen returns the number of bytes EncodeRunes needs to encode all of p.
+constexpr int64 EncodedLen(span<rune const> p);
+
 // RuneCount returns the number of runes in p. Erroneous and short
 // encodings are treated as single runes of width 1 byte.
 constexpr int64 RuneCount(span<uint8 const> p);
@@ -91,6 +131,94 @@ constexpr bool Valid(span<uint8 const> p);
 // ValidString reports whether s consists entirely of valid UTF-8-encoded runes.
 constexpr bool ValidString(string_view s);
 
+// kMinParallelChunk is the smallest piece of input that ValidParallel and
+// RuneCountParallel hand to a thread of its own.
+constexpr uint64 kMinParallelChunk = uint64{1} << 20;
+
+// ValidParallel is like Valid but splits p into chunks checked on up to
+// threads threads at once. If threads is 0 it uses one per hardware thread.
+bool ValidParallel(span<uint8 const> p, int32 threads = 0);
+
+// RuneCountParallel is like RuneCount but splits p into chunks counted on up
+// to threads threads at once. If threads is 0 it uses one per hardware
+// thread.
+int64 RuneCountParallel(span<uint8 const> p, int32 threads = 0);
+
+// error_kind describes the first invalid sequence found by FirstInvalid.
+enum class error_kind : uint8 {
+  kNone,         // The input is valid.
+  kBadLeadByte,  // A continuation byte, or a byte that never starts a rune.
+  kOverlong,     // A longer encoding than the rune needs.
+  kSurrogate,    // The encoding of a surrogate half.
+  kTruncated,    // A lead byte not followed by enough continuation bytes.
+  kOutOfRange,   // The encoding of a value above kMaxRune.
+};
+
+// FirstInvalid returns the offset of the first invalid sequence in p and the
+// reason it is invalid. If p is valid it returns (len(p), error_kind::kNone),
+// so the offset is also the length of the longest valid prefix of p.
+constexpr pair<int64, error_kind> FirstInvalid(span<uint8 const> p);
+
+// FirstInvalidInString is like FirstInvalid but its input is a string.
+constexpr pair<int64, error_kind> FirstInvalidInString(string_view s);
+
+// text_stats describes a text the way DecodeRune steps through it, so each
+// byte of an invalid encoding counts as one RuneError.
+struct text_stats {
+  bool valid = true;
+  // first_invalid and error are the result of FirstInvalid.
+  int64 first_invalid = 0;
+  error_kind error = error_kind::kNone;
+  // ascii is set if every byte is below kRuneSelf.
+  bool ascii = true;
+  int64 runes = 0;
+  // utf16_len is the number of UTF-16 units the text converts to.
+  int64 utf16_len = 0;
+  // max_width is the width of the widest rune, or 0 for an empty text.
+  int8 max_width = 0;
+
+  constexpr bool operator==(text_stats const&) const = default;
+};
+
+// Analyze returns the text_stats of p in a single pass over it.
+constexpr text_stats Analyze(span<uint8 const> p);
+
+// AnalyzeString is like Analyze but its input is a string.
+constexpr text_stats AnalyzeString(string_view s);
+
+// stream_validator reports whether a stream of bytes, fed to it in pieces of
+// any size, is valid UTF-8. A sequence split across pieces is held until the
+// piece that completes it arrives; at most kUTFMax-1 bytes are kept.
+class stream_validator {
+ public:
+  constexpr stream_validator() = default;
+
+  // Feed validates the next piece of the stream. It returns false once the
+  // stream is known to be invalid; later calls do nothing.
+  constexpr bool Feed(span<uint8 const> p);
+
+  // Finish reports whether the stream fed so far is valid and does not end
+  // in the middle of a sequence.
+  constexpr bool Finish() const;
+
+ private:
+  array<uint8, kUTFMax - 1> pending_{};
+  uint8 npending_ = 0;
+  bool ok_ = true;
+};
+
+// kRuneErrorBytes is the UTF-8 encoding of RuneError.
+constexpr uint8 kRuneErrorBytes[] = {0xEF, 0xBF, 0xBD};
+
+// ToValidUTF8 returns s with each run of invalid UTF-8 byte sequences
+// replaced by replacement, which may be empty. If s is valid it is returned
+// as is and out is left alone; otherwise the result is built in out and
+// refers to it.
+constexpr string_view ToValidUTF8(string_view s, string& out,
+                                  string_view replacement = {
+                                      kRuneErrorBytes,
+                                      sizeof(kRuneErrorBytes)});
+
 // ValidRune reports whether r can be legally encoded as UTF-8.
 // Code points that are out of range or a surrogate half are illegal.
 constexpr bool ValidRune(rune r);
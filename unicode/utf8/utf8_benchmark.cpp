@@ -1,5 +1,6 @@
 #include "benchmark/benchmark.h"
 #include "types.hpp"
+#include "unicode/utf8/builder.hpp"
 #include "unicode/utf8/utf8.hpp"
 
 namespace rflx {
@@ -96,6 +97,533 @@ void BenchmarkValidStringTenJapaneseChars(benchmark::State& state) {
 
 BENCHMARK(BenchmarkValidStringTenJapaneseChars)->Range(1, 256);
 
+// Long inputs exercise the vector kernels rather than per call overhead.
+slice<uint8> LongInput(string_view chunk, uint64 size) {
+  slice<uint8> b;
+  b.reserve(size + chunk.Size());
+  while (b.size() < size) {
+    b.insert(b.end(), chunk.Data(), chunk.Data() + chunk.Size());
+  }
+  return b;
+}
+
+slice<uint8> ASCIIInput(uint64 size) {
+  string_literal s = "0123456789";
+  return LongInput({s.Data(), s.Size()}, size);
+}
+
+slice<uint8> JapaneseInput(uint64 size) {
+  string_literal s = "日本語日本語日本語日";
+  return LongInput({s.Data(), s.Size()}, size);
+}
+
+// MixedInput strings together runes of every width in an order that does
+// not repeat, the way multilingual text switches scripts.
+slice<uint8> MixedInput(uint64 size) {
+  constexpr rune runes[] = {'a', ' ', 0xE7, 0x0431, 0x65E5, 0x8A9E, 0x1F600};
+  slice<uint8> b(size + kUTFMax);
+  uint64 n = 0;
+  uint32 x = 1;
+  while (n < size) {
+    x = x * 1103515245 + 12345;
+    n += EncodeRune({b.data() + n, kUTFMax}, runes[(x >> 16) % 7]);
+  }
+  b.resize(n);
+  return b;
+}
+
+void BenchmarkValidLongASCII(benchmark::State& state) {
+  string_literal s = "0123456789";
+  slice<uint8> const b = LongInput({s.Data(), s.Size()}, state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Valid({b.data(), b.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkValidLongASCII)->Range(1 << 10, 1 << 20);
+
+void BenchmarkValidLongJapanese(benchmark::State& state) {
+  string_literal s = "日本語日本語日本語日";
+  slice<uint8> const b = LongInput({s.Data(), s.Size()}, state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Valid({b.data(), b.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkValidLongJapanese)->Range(1 << 10, 1 << 20);
+
+void BenchmarkValidLongMixed(benchmark::State& state) {
+  string_literal s = "日a本b語ç日ð本Ê語þ日¥本¼語i日©";
+  slice<uint8> const b = LongInput({s.Data(), s.Size()}, state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Valid({b.data(), b.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkValidLongMixed)->Range(1 << 10, 1 << 20);
+
+void BenchmarkAnalyzeLongASCII(benchmark::State& state) {
+  slice<uint8> const b = ASCIIInput(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Analyze({b.data(), b.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkAnalyzeLongASCII)->Range(1 << 10, 1 << 20);
+
+void BenchmarkAnalyzeLongJapanese(benchmark::State& state) {
+  slice<uint8> const b = JapaneseInput(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Analyze({b.data(), b.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkAnalyzeLongJapanese)->Range(1 << 10, 1 << 20);
+
+void BenchmarkAnalyzeLongMixed(benchmark::State& state) {
+  slice<uint8> const b = MixedInput(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Analyze({b.data(), b.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkAnalyzeLongMixed)->Range(1 << 10, 1 << 20);
+
+void BenchmarkStreamValidatorLongJapanese(benchmark::State& state) {
+  string_literal s = "日本語日本語日本語日";
+  slice<uint8> const b = LongInput({s.Data(), s.Size()}, 1 << 20);
+  // Pieces of a typical network payload size, which split many runes.
+  uint64 const piece = state.range(0);
+  for (auto _ : state) {
+    stream_validator v;
+    for (uint64 i = 0; i < b.size(); i += piece) {
+      uint64 const n = b.size() - i < piece ? b.size() - i : piece;
+      v.Feed({b.data() + i, n});
+    }
+    benchmark::DoNotOptimize(v.Finish());
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkStreamValidatorLongJapanese)->Arg(1460)->Arg(16 << 10);
+
+void BenchmarkToValidUTF8LongValid(benchmark::State& state) {
+  string_literal s = "日本語日本語日本語日";
+  slice<uint8> const b = LongInput({s.Data(), s.Size()}, state.range(0));
+  for (auto _ : state) {
+    string out;
+    benchmark::DoNotOptimize(ToValidUTF8({b.data(), b.size()}, out));
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkToValidUTF8LongValid)->Range(1 << 10, 1 << 20);
+
+void BenchmarkToValidUTF8LongInvalid(benchmark::State& state) {
+  string_literal s = "日本語日本語日本語日本語日本語日本語日本語日本語日\xff";
+  slice<uint8> const b = LongInput({s.Data(), s.Size()}, state.range(0));
+  for (auto _ : state) {
+    string out;
+    benchmark::DoNotOptimize(ToValidUTF8({b.data(), b.size()}, out));
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkToValidUTF8LongInvalid)->Range(1 << 10, 1 << 20);
+
+void BenchmarkValidParallelJapanese(benchmark::State& state) {
+  string_literal s = "日本語日本語日本語日";
+  slice<uint8> const b = LongInput({s.Data(), s.Size()}, 1 << 28);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ValidParallel({b.data(), b.size()}, state.range(0)));
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkValidParallelJapanese)
+    ->RangeMultiplier(2)
+    ->Range(1, 32)
+    ->UseRealTime();
+
+void BenchmarkRuneCountParallelJapanese(benchmark::State& state) {
+  string_literal s = "日本語日本語日本語日";
+  slice<uint8> const b = LongInput({s.Data(), s.Size()}, 1 << 28);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        RuneCountParallel({b.data(), b.size()}, state.range(0)));
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkRuneCountParallelJapanese)
+    ->RangeMultiplier(2)
+    ->Range(1, 32)
+    ->UseRealTime();
+
+void BenchmarkRuneCountLongASCII(benchmark::State& state) {
+  string_literal s = "0123456789";
+  slice<uint8> const b = LongInput({s.Data(), s.Size()}, state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(RuneCount({b.data(), b.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkRuneCountLongASCII)->Range(1 << 10, 1 << 20);
+
+void BenchmarkRuneCountLongJapanese(benchmark::State& state) {
+  string_literal s = "日本語日本語日本語日";
+  slice<uint8> const b = LongInput({s.Data(), s.Size()}, state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(RuneCount({b.data(), b.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkRuneCountLongJapanese)->Range(1 << 10, 1 << 20);
+
+void BenchmarkRuneCountLongInvalid(benchmark::State& state) {
+  string_literal s = "日本語\x80日本語\xe6\x97日本語日";
+  slice<uint8> const b = LongInput({s.Data(), s.Size()}, state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(RuneCount({b.data(), b.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkRuneCountLongInvalid)->Range(1 << 10, 1 << 20);
+
+void BenchmarkDecodeRunesLongASCII(benchmark::State& state) {
+  string_literal s = "0123456789";
+  slice<uint8> const b = LongInput({s.Data(), s.Size()}, state.range(0));
+  slice<rune> out(b.size());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        DecodeRunes({b.data(), b.size()}, {out.data(), out.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkDecodeRunesLongASCII)->Range(1 << 10, 1 << 20);
+
+void BenchmarkDecodeRunesLongJapanese(benchmark::State& state) {
+  string_literal s = "日本語日本語日本語日";
+  slice<uint8> const b = LongInput({s.Data(), s.Size()}, state.range(0));
+  slice<rune> out(b.size());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        DecodeRunes({b.data(), b.size()}, {out.data(), out.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkDecodeRunesLongJapanese)->Range(1 << 10, 1 << 20);
+
+void BenchmarkDecodeRunesLongCyrillic(benchmark::State& state) {
+  string_literal s = "брэдЛГТМ";
+  slice<uint8> const b = LongInput({s.Data(), s.Size()}, state.range(0));
+  slice<rune> out(b.size());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        DecodeRunes({b.data(), b.size()}, {out.data(), out.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkDecodeRunesLongCyrillic)->Range(1 << 10, 1 << 20);
+
+void BenchmarkDecodeRunesLongMixed(benchmark::State& state) {
+  slice<uint8> const b = MixedInput(state.range(0));
+  slice<rune> out(b.size());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        DecodeRunes({b.data(), b.size()}, {out.data(), out.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkDecodeRunesLongMixed)->Range(1 << 10, 1 << 20);
+
+void BenchmarkDecodeRunesLongEmoji(benchmark::State& state) {
+  string_literal s = "😀😃😄😁";
+  slice<uint8> const b = LongInput({s.Data(), s.Size()}, state.range(0));
+  slice<rune> out(b.size());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        DecodeRunes({b.data(), b.size()}, {out.data(), out.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkDecodeRunesLongEmoji)->Range(1 << 10, 1 << 20);
+
+// RunesOf decodes b, which must be valid.
+slice<rune> RunesOf(slice<uint8> const& b) {
+  slice<rune> runes(b.size());
+  auto const [n, _] =
+      DecodeRunes({b.data(), b.size()}, {runes.data(), runes.size()});
+  runes.resize(n);
+  return runes;
+}
+
+void BenchmarkEncodeRunesLongASCII(benchmark::State& state) {
+  string_literal s = "0123456789";
+  slice<rune> const runes =
+      RunesOf(LongInput({s.Data(), s.Size()}, state.range(0)));
+  slice<uint8> out(EncodedLen({runes.data(), runes.size()}));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        EncodeRunes({runes.data(), runes.size()}, {out.data(), out.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * out.size());
+}
+
+BENCHMARK(BenchmarkEncodeRunesLongASCII)->Range(1 << 10, 1 << 20);
+
+void BenchmarkEncodeRunesLongJapanese(benchmark::State& state) {
+  string_literal s = "日本語日本語日本語日";
+  slice<rune> const runes =
+      RunesOf(LongInput({s.Data(), s.Size()}, state.range(0)));
+  slice<uint8> out(EncodedLen({runes.data(), runes.size()}));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        EncodeRunes({runes.data(), runes.size()}, {out.data(), out.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * out.size());
+}
+
+BENCHMARK(BenchmarkEncodeRunesLongJapanese)->Range(1 << 10, 1 << 20);
+
+void BenchmarkEncodeRunesLongCyrillic(benchmark::State& state) {
+  string_literal s = "брэдЛГТМ";
+  slice<rune> const runes =
+      RunesOf(LongInput({s.Data(), s.Size()}, state.range(0)));
+  slice<uint8> out(EncodedLen({runes.data(), runes.size()}));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        EncodeRunes({runes.data(), runes.size()}, {out.data(), out.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * out.size());
+}
+
+BENCHMARK(BenchmarkEncodeRunesLongCyrillic)->Range(1 << 10, 1 << 20);
+
+void BenchmarkEncodeRunesLongMixed(benchmark::State& state) {
+  slice<rune> const runes = RunesOf(MixedInput(state.range(0)));
+  slice<uint8> out(EncodedLen({runes.data(), runes.size()}));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        EncodeRunes({runes.data(), runes.size()}, {out.data(), out.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * out.size());
+}
+
+BENCHMARK(BenchmarkEncodeRunesLongMixed)->Range(1 << 10, 1 << 20);
+
+void BenchmarkEncodeRunesLongEmoji(benchmark::State& state) {
+  string_literal s = "😀😃😄😁";
+  slice<rune> const runes =
+      RunesOf(LongInput({s.Data(), s.Size()}, state.range(0)));
+  slice<uint8> out(EncodedLen({runes.data(), runes.size()}));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        EncodeRunes({runes.data(), runes.size()}, {out.data(), out.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * out.size());
+}
+
+BENCHMARK(BenchmarkEncodeRunesLongEmoji)->Range(1 << 10, 1 << 20);
+
+void BenchmarkEncodedLenLongJapanese(benchmark::State& state) {
+  string_literal s = "日本語日本語日本語日";
+  slice<rune> const runes =
+      RunesOf(LongInput({s.Data(), s.Size()}, state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(EncodedLen({runes.data(), runes.size()}));
+  }
+  state.SetBytesProcessed(state.iterations() * runes.size() * sizeof(rune));
+}
+
+BENCHMARK(BenchmarkEncodedLenLongJapanese)->Range(1 << 10, 1 << 20);
+
+// DecodeRuneLoop steps through a long input one DecodeRune at a time, as
+// callers that handle each rune do.
+template <typename Decoder>
+void DecodeRuneLoop(benchmark::State& state,
+                    slice<uint8> (*input)(uint64 size)) {
+  slice<uint8> const b = input(state.range(0));
+  for (auto _ : state) {
+    rune sum = 0;
+    for (uint64 i = 0; i < b.size();) {
+      auto const [r, size] = DecodeRune<Decoder>({b.data() + i, b.size() - i});
+      sum += r;
+      i += size;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+void BenchmarkDecodeRuneTable(benchmark::State& state,
+                              slice<uint8> (*input)(uint64 size)) {
+  DecodeRuneLoop<table_decoder>(state, input);
+}
+
+void BenchmarkDecodeRuneDFA(benchmark::State& state,
+                            slice<uint8> (*input)(uint64 size)) {
+  DecodeRuneLoop<dfa_decoder>(state, input);
+}
+
+BENCHMARK_CAPTURE(BenchmarkDecodeRuneTable, ASCII, ASCIIInput)
+    ->Range(1 << 10, 1 << 16);
+BENCHMARK_CAPTURE(BenchmarkDecodeRuneTable, Japanese, JapaneseInput)
+    ->Range(1 << 10, 1 << 16);
+BENCHMARK_CAPTURE(BenchmarkDecodeRuneTable, Mixed, MixedInput)
+    ->Range(1 << 10, 1 << 16);
+
+BENCHMARK_CAPTURE(BenchmarkDecodeRuneDFA, ASCII, ASCIIInput)
+    ->Range(1 << 10, 1 << 16);
+BENCHMARK_CAPTURE(BenchmarkDecodeRuneDFA, Japanese, JapaneseInput)
+    ->Range(1 << 10, 1 << 16);
+BENCHMARK_CAPTURE(BenchmarkDecodeRuneDFA, Mixed, MixedInput)
+    ->Range(1 << 10, 1 << 16);
+
+void BenchmarkStringIteratorLongJapanese(benchmark::State& state) {
+  slice<uint8> const b = JapaneseInput(state.range(0));
+  string_view const s{b.data(), b.size()};
+  for (auto _ : state) {
+    rune sum = 0;
+    for (rune const r : s) {
+      sum += r;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkStringIteratorLongJapanese)->Range(1 << 10, 1 << 16);
+
+// BenchmarkStringShortKeys builds a slice of identifier sized strings.
+void BenchmarkStringShortKeys(benchmark::State& state) {
+  string_literal const key = "user_id_0123";
+  for (auto _ : state) {
+    slice<string> keys;
+    keys.reserve(state.range(0));
+    for (int64 i = 0; i < state.range(0); ++i) {
+      keys.emplace_back(key.Data(), key.Size());
+    }
+    benchmark::DoNotOptimize(keys.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BenchmarkStringShortKeys)->Range(1 << 4, 1 << 12);
+
+// The LongKeys benchmarks build and drop a slice of strings too long to be
+// stored inline, as a request handler would.
+constexpr uint64 kLongKeySize = 40;
+
+void BenchmarkStringLongKeysHeap(benchmark::State& state) {
+  slice<uint8> const key(kLongKeySize, 'k');
+  for (auto _ : state) {
+    slice<string> keys;
+    keys.reserve(state.range(0));
+    for (int64 i = 0; i < state.range(0); ++i) {
+      keys.emplace_back(key.data(), key.size());
+    }
+    benchmark::DoNotOptimize(keys.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BenchmarkStringLongKeysHeap)->Range(1 << 4, 1 << 12);
+
+void BenchmarkStringLongKeysArena(benchmark::State& state) {
+  slice<uint8> const key(kLongKeySize, 'k');
+  slice<uint8> buffer(state.range(0) * (sizeof(string) + 64));
+  for (auto _ : state) {
+    arena a{buffer.data(), buffer.size()};
+    pmr::slice<string> keys{&a};
+    keys.reserve(state.range(0));
+    for (int64 i = 0; i < state.range(0); ++i) {
+      keys.emplace_back(key.data(), key.size(), &a);
+    }
+    benchmark::DoNotOptimize(keys.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BenchmarkStringLongKeysArena)->Range(1 << 4, 1 << 12);
+
+// The Concat benchmarks assemble a response from state.range(0) fragments.
+slice<string_view> Fragments(int64 n) {
+  static string_literal const fragment = "<td>日本語 fragment</td>";
+  return slice<string_view>(n, {fragment.Data(), fragment.Size()});
+}
+
+void BenchmarkConcatOperatorPlus(benchmark::State& state) {
+  slice<string_view> const parts = Fragments(state.range(0));
+  for (auto _ : state) {
+    string s;
+    for (string_view const& part : parts) {
+      s = s + string{part.Data(), part.Size()};
+    }
+    benchmark::DoNotOptimize(s.Data());
+  }
+  state.SetItemsProcessed(state.iterations() * parts.size());
+}
+
+BENCHMARK(BenchmarkConcatOperatorPlus)->Range(1 << 3, 1 << 9);
+
+void BenchmarkConcatBuilder(benchmark::State& state) {
+  slice<string_view> const parts = Fragments(state.range(0));
+  for (auto _ : state) {
+    string_builder b;
+    for (string_view const& part : parts) {
+      b.Append(part);
+    }
+    string const s = b.Finish();
+    benchmark::DoNotOptimize(s.Data());
+  }
+  state.SetItemsProcessed(state.iterations() * parts.size());
+}
+
+BENCHMARK(BenchmarkConcatBuilder)->Range(1 << 3, 1 << 9);
+
+void BenchmarkConcatJoin(benchmark::State& state) {
+  slice<string_view> const parts = Fragments(state.range(0));
+  for (auto _ : state) {
+    string const s = Join({parts.data(), parts.size()}, {});
+    benchmark::DoNotOptimize(s.Data());
+  }
+  state.SetItemsProcessed(state.iterations() * parts.size());
+}
+
+BENCHMARK(BenchmarkConcatJoin)->Range(1 << 3, 1 << 9);
+
+void BenchmarkBuilderWriteRuneJapanese(benchmark::State& state) {
+  slice<uint8> const b = JapaneseInput(state.range(0));
+  slice<rune> runes(b.size());
+  runes.resize(DecodeRunes(b, {runes.data(), runes.size()}).second);
+  for (auto _ : state) {
+    string_builder builder;
+    for (rune const r : runes) {
+      builder.WriteRune(r);
+    }
+    benchmark::DoNotOptimize(builder.View().Data());
+  }
+  state.SetBytesProcessed(state.iterations() * b.size());
+}
+
+BENCHMARK(BenchmarkBuilderWriteRuneJapanese)->Range(1 << 10, 1 << 16);
+
 void BenchmarkEncodeASCIIRune(benchmark::State& state) {
   array<uint8, kUTFMax> buf;
   for (auto _ : state) {
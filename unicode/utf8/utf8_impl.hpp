@@ -1,5 +1,7 @@
 #pragma once
 
+#include <type_traits>
+
 #include "unicode/utf8/utf8.hpp"
 
 namespace rflx {
@@ -43,14 +45,53 @@ constexpr uint8 ks6 = 0x04;  // accept 0, size 4
 constexpr uint8 ks7 = 0x44;  // accept 4, size 4
 
 // first is information about the first byte in a UTF-8 sequence.
-extern uint8 const kFirst[256];
+inline constexpr uint8 kFirst[256] = {
+    // clang-format off
+    //   1    2    3    4    5    6    7    8    9    A    B    C    D    E    F
+    kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, // 0x00-0x0F
+    kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, // 0x10-0x1F
+    kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, // 0x20-0x2F
+    kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, // 0x30-0x3F
+    kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, // 0x40-0x4F
+    kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, // 0x50-0x5F
+    kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, // 0x60-0x6F
+    kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, kas, // 0x70-0x7F
+
+    //   1    2    3    4    5    6    7    8    9    A    B    C    D    E    F
+    kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, // 0x80-0x8F
+    kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, // 0x90-0x9F
+    kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, // 0xA0-0xAF
+    kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, // 0xB0-0xBF
+    kxx, kxx, ks1, ks1, ks1, ks1, ks1, ks1, ks1, ks1, ks1, ks1, ks1, ks1, ks1, ks1, // 0xC0-0xCF
+    ks1, ks1, ks1, ks1, ks1, ks1, ks1, ks1, ks1, ks1, ks1, ks1, ks1, ks1, ks1, ks1, // 0xD0-0xDF
+    ks2, ks3, ks3, ks3, ks3, ks3, ks3, ks3, ks3, ks3, ks3, ks3, ks3, ks4, ks3, ks3, // 0xE0-0xEF
+    ks5, ks6, ks6, ks6, ks7, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, kxx, // 0xF0-0xFF
+    // clang-format on
+};
 
 struct _accept_range {
   uint8 lo;  // lowest value for second byte.
   uint8 hi;  // highest value for second byte.
 };
 
-extern _accept_range const _accept_ranges[16];
+inline constexpr _accept_range _accept_ranges[16] = {
+    {klocb, khicb},
+    {0xA0, khicb},
+    {klocb, 0x9F},
+    {0x90, khicb},
+    {klocb, 0x8F},
+};
+
+// The functions over whole buffers come in two flavours. The scalar ones
+// walk one sequence at a time and are used during constant evaluation, for
+// short inputs and on CPUs without a vector unit. The simd ones are defined in
+// utf8_simd.cpp and pick the widest instruction set of the running CPU.
+namespace simd {
+
+// Inputs shorter than this are handled by the scalar loops.
+constexpr uint64 kMinSize = 32;
+
+}  // namespace simd
 
 constexpr bool FullRune(span<uint8 const> p) {
   uint64 const n = p.size();
@@ -76,7 +117,7 @@ constexpr bool FullRuneInString(string_view p) {
   return FullRune({p.Data(), p.Size()});
 }
 
-constexpr pair<rune, int8> DecodeRune(span<uint8 const> p) {
+constexpr pair<rune, int8> table_decoder::DecodeRune(span<uint8 const> p) {
   uint64 const n = p.size();
 
   if (n < 1) {
@@ -136,8 +177,146 @@ constexpr pair<rune, int8> DecodeRune(span<uint8 const> p) {
           4};
 }
 
+// The DFA decoder sorts bytes into classes that differ in what they may
+// follow or be followed by. The names again give nice alignment in the table.
+constexpr uint8 kda = 0;   // ASCII
+constexpr uint8 kd8 = 1;   // continuation 0x80-0x8F
+constexpr uint8 kd9 = 2;   // continuation 0x90-0x9F
+constexpr uint8 kdb = 3;   // continuation 0xA0-0xBF
+constexpr uint8 kd2 = 4;   // lead of two bytes
+constexpr uint8 kd0 = 5;   // 0xE0, second byte 0xA0-0xBF
+constexpr uint8 kd3 = 6;   // lead of three bytes
+constexpr uint8 kdd = 7;   // 0xED, second byte 0x80-0x9F
+constexpr uint8 kdf = 8;   // 0xF0, second byte 0x90-0xBF
+constexpr uint8 kd4 = 9;   // lead of four bytes
+constexpr uint8 kde = 10;  // 0xF4, second byte 0x80-0x8F
+constexpr uint8 kdx = 11;  // never valid
+constexpr uint8 kdz = 12;  // past the end of the input
+
+inline constexpr uint8 kDFAClass[256] = {
+    // clang-format off
+    //   1    2    3    4    5    6    7    8    9    A    B    C    D    E    F
+    kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, // 0x00-0x0F
+    kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, // 0x10-0x1F
+    kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, // 0x20-0x2F
+    kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, // 0x30-0x3F
+    kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, // 0x40-0x4F
+    kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, // 0x50-0x5F
+    kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, // 0x60-0x6F
+    kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, kda, // 0x70-0x7F
+
+    //   1    2    3    4    5    6    7    8    9    A    B    C    D    E    F
+    kd8, kd8, kd8, kd8, kd8, kd8, kd8, kd8, kd8, kd8, kd8, kd8, kd8, kd8, kd8, kd8, // 0x80-0x8F
+    kd9, kd9, kd9, kd9, kd9, kd9, kd9, kd9, kd9, kd9, kd9, kd9, kd9, kd9, kd9, kd9, // 0x90-0x9F
+    kdb, kdb, kdb, kdb, kdb, kdb, kdb, kdb, kdb, kdb, kdb, kdb, kdb, kdb, kdb, kdb, // 0xA0-0xAF
+    kdb, kdb, kdb, kdb, kdb, kdb, kdb, kdb, kdb, kdb, kdb, kdb, kdb, kdb, kdb, kdb, // 0xB0-0xBF
+    kdx, kdx, kd2, kd2, kd2, kd2, kd2, kd2, kd2, kd2, kd2, kd2, kd2, kd2, kd2, kd2, // 0xC0-0xCF
+    kd2, kd2, kd2, kd2, kd2, kd2, kd2, kd2, kd2, kd2, kd2, kd2, kd2, kd2, kd2, kd2, // 0xD0-0xDF
+    kd0, kd3, kd3, kd3, kd3, kd3, kd3, kd3, kd3, kd3, kd3, kd3, kd3, kdd, kd3, kd3, // 0xE0-0xEF
+    kdf, kd4, kd4, kd4, kde, kdx, kdx, kdx, kdx, kdx, kdx, kdx, kdx, kdx, kdx, kdx, // 0xF0-0xFF
+    // clang-format on
+};
+
+// The states of the DFA decoder. Done and reject take every class to
+// themselves.
+constexpr uint8 kqa = 0;  // done
+constexpr uint8 kqr = 1;  // reject
+constexpr uint8 kqs = 2;  // start
+constexpr uint8 kq1 = 3;  // one continuation byte left
+constexpr uint8 kq2 = 4;  // two continuation bytes left
+constexpr uint8 kq3 = 5;  // three continuation bytes left
+constexpr uint8 kq0 = 6;  // after 0xE0
+constexpr uint8 kqd = 7;  // after 0xED
+constexpr uint8 kqf = 8;  // after 0xF0
+constexpr uint8 kqe = 9;  // after 0xF4
+
+constexpr uint8 kDFAStates = 10;
+
+inline constexpr uint8 kDFATransitions[kDFAStates][16] = {
+    // clang-format off
+    // One column per class, kda to kdz, then padding.
+    {kqa, kqa, kqa, kqa, kqa, kqa, kqa, kqa, kqa, kqa, kqa, kqa, kqa, kqa, kqa, kqa},  // kqa
+    {kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr},  // kqr
+    {kqa, kqr, kqr, kqr, kq1, kq0, kq2, kqd, kqf, kq3, kqe, kqr, kqr, kqr, kqr, kqr},  // kqs
+    {kqr, kqa, kqa, kqa, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr},  // kq1
+    {kqr, kq1, kq1, kq1, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr},  // kq2
+    {kqr, kq2, kq2, kq2, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr},  // kq3
+    {kqr, kqr, kqr, kq1, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr},  // kq0
+    {kqr, kq1, kq1, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr},  // kqd
+    {kqr, kqr, kq2, kq2, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr},  // kqf
+    {kqr, kq2, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr, kqr},  // kqe
+    // clang-format on
+};
+
+// kDFALength is the length of the encoding led by a byte of each class. Bytes
+// that cannot lead one decode as a single invalid byte.
+inline constexpr uint8 kDFALength[16] = {1, 1, 1, 1, 2, 3, 3, 3, 4, 4, 4, 1, 1};
+
+// kDFALeadMask holds the payload bits of a first byte, by length.
+inline constexpr uint8 kDFALeadMask[kUTFMax + 1] = {0, 0x7F, kmask2, kmask3,
+                                                    kmask4};
+
+// The decoder runs on one word per byte, built from the tables above. Bits
+// [6q, 6q+6) hold 6 times the state that follows the byte in state q, so that
+// a step is a shift whose table load does not wait for the previous step, and
+// bits 60 and up hold kDFALength. The word after the last byte is for the end
+// of the input.
+constexpr array<uint64, 257> DFARows() {
+  array<uint64, 257> rows{};
+  for (uint64 b = 0; b < rows.size(); ++b) {
+    uint8 const c = b < 256 ? kDFAClass[b] : kdz;
+    uint64 row = uint64{kDFALength[c]} << 60;
+    for (uint8 q = 0; q < kDFAStates; ++q) {
+      row |= uint64{6} * kDFATransitions[q][c] << (6 * q);
+    }
+    rows[b] = row;
+  }
+  return rows;
+}
+
+inline constexpr array<uint64, 257> kDFARows = DFARows();
+
+constexpr pair<rune, int8> dfa_decoder::DecodeRune(span<uint8 const> p) {
+  uint64 const n = p.size();
+
+  if (n < 1) {
+    return {kRuneError, 0};
+  }
+
+  // Always take four steps. Bytes past the end of p are read as the first
+  // byte and step with the end of input word; once the state is done, no
+  // word changes it.
+  uint8 const b0 = p[0];
+  uint8 const b1 = p[n > 1 ? 1 : 0];
+  uint8 const b2 = p[n > 2 ? 2 : 0];
+  uint8 const b3 = p[n > 3 ? 3 : 0];
+  uint64 const w0 = kDFARows[b0];
+  uint64 state = (w0 >> (6 * kqs)) & 63;
+  state = (kDFARows[n > 1 ? b1 : 256] >> state) & 63;
+  state = (kDFARows[n > 2 ? b2 : 256] >> state) & 63;
+  state = (kDFARows[n > 3 ? b3 : 256] >> state) & 63;
+
+  // Assemble all four bytes and drop the ones past the encoding.
+  uint64 const len = w0 >> 60;
+  rune const r = (rune(b0 & kDFALeadMask[len]) << 18 |
+                  rune(b1 & kmaskx) << 12 | rune(b2 & kmaskx) << 6 |
+                  rune(b3 & kmaskx)) >>
+                 (6 * (kUTFMax - len));
+
+  // Select the error result with a mask; compilers turn a conditional here
+  // into a branch.
+  uint64 const bad = -uint64{state != 6 * kqa};
+  return {rune(r ^ ((r ^ kRuneError) & bad)), int8(len ^ ((len ^ 1) & bad))};
+}
+
+template <typename Decoder>
+constexpr pair<rune, int8> DecodeRune(span<uint8 const> p) {
+  return Decoder::DecodeRune(p);
+}
+
+template <typename Decoder>
 constexpr pair<rune, int8> DecodeRuneInString(string_view string) {
-  return DecodeRune({string.Data(), string.Size()});
+  return DecodeRune<Decoder>({string.Data(), string.Size()});
 }
 
 constexpr pair<rune, int8> DecodeLastRune(span<uint8 const> p) {
@@ -181,6 +360,44 @@ constexpr pair<rune, int8> DecodeLastRuneInString(string_view s) {
   return DecodeLastRune({s.Data(), s.Size()});
 }
 
+namespace scalar {
+
+// DecodeRunes calls DecodeRune once per rune.
+constexpr pair<int64, int64> DecodeRunes(span<uint8 const> p, span<rune> out) {
+  uint64 i = 0;
+  uint64 k = 0;
+  while (i < p.size() && k < out.size()) {
+    auto const [r, size] = DecodeRune(p.subspan(i));
+    out[k] = r;
+    ++k;
+    i += size;
+  }
+  return {k, i};
+}
+
+}  // namespace scalar
+
+namespace simd {
+
+// DecodeRunes widens runs of ASCII and decodes blocks made only of two or
+// only of three byte sequences in vector registers. Anything else is decoded
+// by DecodeRune.
+pair<int64, int64> DecodeRunes(span<uint8 const> p, span<rune> out);
+
+}  // namespace simd
+
+constexpr pair<int64, int64> DecodeRunes(span<uint8 const> p, span<rune> out) {
+  if (std::is_constant_evaluated() || p.size() < simd::kMinSize) {
+    return scalar::DecodeRunes(p, out);
+  }
+  return simd::DecodeRunes(p, out);
+}
+
+constexpr pair<int64, int64> DecodeRunesInString(string_view s,
+                                                 span<rune> out) {
+  return DecodeRunes({s.Data(), s.Size()}, out);
+}
+
 constexpr int8 RuneLen(rune r) {
   if (r < krune1Max) {
     return 1;
@@ -235,6 +452,70 @@ constexpr int32 EncodeRune(span<uint8> p, rune r) {
   return 4;
 }
 
+namespace scalar {
+
+// EncodedLen classifies one rune at a time.
+constexpr int64 EncodedLen(span<rune const> p) {
+  int64 n = 0;
+  for (rune const r : p) {
+    if (r <= krune1Max) {
+      n += 1;
+    } else if (r <= krune2Max) {
+      n += 2;
+    } else if ((r <= krune3Max) || (r > kMaxRune)) {
+      n += 3;  // Surrogates and invalid runes become RuneError.
+    } else {
+      n += 4;
+    }
+  }
+  return n;
+}
+
+// EncodeRunes calls EncodeRune once per rune.
+constexpr pair<int64, int64> EncodeRunes(span<rune const> p, span<uint8> out) {
+  uint64 i = 0;
+  uint64 k = 0;
+  for (; i < p.size(); ++i) {
+    if (out.size() - k < kUTFMax &&
+        static_cast<uint64>(EncodedLen(p.subspan(i, 1))) > out.size() - k) {
+      break;
+    }
+    k += EncodeRune(out.subspan(k), p[i]);
+  }
+  return {i, k};
+}
+
+}  // namespace scalar
+
+namespace simd {
+
+// EncodedLen sums rune widths computed four at a time.
+int64 EncodedLen(span<rune const> p);
+
+// EncodeRunes packs runs of ASCII and encodes blocks made only of two or
+// only of three byte runes in vector registers. Anything else is encoded by
+// EncodeRune.
+pair<int64, int64> EncodeRunes(span<rune const> p, span<uint8> out);
+
+}  // namespace simd
+
+constexpr pair<int64, int64> EncodeRunes(span<rune const> p, span<uint8> out) {
+  if (std::is_constant_evaluated() || p.size() < simd::kMinSize) {
+    return scalar::EncodeRunes(p, out);
+  }
+  return simd::EncodeRunes(p, out);
+}
+
+constexpr int64 EncodedLen(span<rune const> p) {
+  if (std::is_constant_evaluated() || p.size() < simd::kMinSize) {
+    return scalar::EncodedLen(p);
+  }
+  return simd::EncodedLen(p);
+}
+
+namespace scalar {
+
+// RuneCount decodes p one sequence at a time.
 constexpr int64 RuneCount(span<uint8 const> p) {
   uint64 const np = p.size();
   int64 n = 0;
@@ -272,12 +553,33 @@ constexpr int64 RuneCount(span<uint8 const> p) {
   return n;
 }
 
+}  // namespace scalar
+
+namespace simd {
+
+// RuneCount counts the runes of p by counting the bytes that are not
+// continuation bytes in the blocks the vector validator accepts. It decodes
+// only around invalid sequences.
+int64 RuneCount(span<uint8 const> p);
+
+}  // namespace simd
+
+constexpr int64 RuneCount(span<uint8 const> p) {
+  if (std::is_constant_evaluated() || p.size() < simd::kMinSize) {
+    return scalar::RuneCount(p);
+  }
+  return simd::RuneCount(p);
+}
+
 constexpr int64 RuneCountInString(string_view s) {
   return RuneCount({s.Data(), s.Size()});
 }
 
 constexpr bool RuneStart(uint8 b) { return (b & 0xC0) != 0x80; }
 
+namespace scalar {
+
+// Valid checks p one sequence at a time.
 constexpr bool Valid(span<uint8 const> p) {
   uint64 n = p.size();
 
@@ -317,10 +619,148 @@ constexpr bool Valid(span<uint8 const> p) {
   return true;
 }
 
+}  // namespace scalar
+
+namespace simd {
+
+// Valid checks p 64 bytes at a time.
+bool Valid(span<uint8 const> p);
+
+}  // namespace simd
+
+constexpr bool Valid(span<uint8 const> p) {
+  if (std::is_constant_evaluated() || p.size() < simd::kMinSize) {
+    return scalar::Valid(p);
+  }
+  return simd::Valid(p);
+}
+
 constexpr bool ValidString(string_view s) {
   return Valid({s.Data(), s.Size()});
 }
 
+// The error for a second byte outside the range of its _accept_range,
+// indexed like _accept_ranges.
+constexpr error_kind kAcceptErrors[5] = {
+    error_kind::kTruncated, error_kind::kOverlong, error_kind::kSurrogate,
+    error_kind::kOverlong, error_kind::kOutOfRange,
+};
+
+namespace scalar {
+
+// FirstInvalid checks p one sequence at a time.
+constexpr pair<int64, error_kind> FirstInvalid(span<uint8 const> p) {
+  uint64 const n = p.size();
+
+  for (uint64 i = 0; i < n;) {
+    uint8 const pi = p[i];
+    if (pi < kRuneSelf) {
+      ++i;
+      continue;
+    }
+
+    uint8 const x = kFirst[pi];
+
+    if (x == kxx) {
+      if (pi < kt2 || pi > 0xF7) {
+        return {i, error_kind::kBadLeadByte};
+      }
+      // 0xC0 and 0xC1 could only start overlong encodings, 0xF5 to 0xF7
+      // values above kMaxRune.
+      return {i, pi < kt3 ? error_kind::kOverlong : error_kind::kOutOfRange};
+    }
+
+    uint64 const size = static_cast<uint64>(x & 7);
+    _accept_range const& accept = _accept_ranges[x >> 4];
+
+    if (i + 1 >= n) {
+      return {i, error_kind::kTruncated};
+    }
+    if (uint8 const c = p[i + 1]; c < accept.lo || accept.hi < c) {
+      if (c < klocb || khicb < c) {
+        return {i, error_kind::kTruncated};
+      }
+      return {i, kAcceptErrors[x >> 4]};
+    }
+    for (uint64 j = 2; j < size; ++j) {
+      if (i + j >= n) {
+        return {i, error_kind::kTruncated};
+      }
+      if (uint8 const c = p[i + j]; c < klocb || khicb < c) {
+        return {i, error_kind::kTruncated};
+      }
+    }
+    i += size;
+  }
+
+  return {n, error_kind::kNone};
+}
+
+}  // namespace scalar
+
+namespace simd {
+
+// FirstInvalid finds the block holding the first error with the vector
+// validator, then locates and classifies it with scalar::FirstInvalid.
+pair<int64, error_kind> FirstInvalid(span<uint8 const> p);
+
+}  // namespace simd
+
+constexpr pair<int64, error_kind> FirstInvalid(span<uint8 const> p) {
+  if (std::is_constant_evaluated() || p.size() < simd::kMinSize) {
+    return scalar::FirstInvalid(p);
+  }
+  return simd::FirstInvalid(p);
+}
+
+constexpr pair<int64, error_kind> FirstInvalidInString(string_view s) {
+  return FirstInvalid({s.Data(), s.Size()});
+}
+
+namespace scalar {
+
+// Analyze decodes p one rune at a time.
+constexpr text_stats Analyze(span<uint8 const> p) {
+  uint64 const n = p.size();
+  text_stats stats;
+  stats.first_invalid = n;
+  for (uint64 i = 0; i < n;) {
+    auto const [r, size] = DecodeRune(p.subspan(i));
+    if (r == kRuneError && size == 1 && stats.valid) {
+      stats.valid = false;
+      stats.first_invalid = i;
+      stats.error = FirstInvalid(p.subspan(i)).second;
+    }
+    ++stats.runes;
+    stats.utf16_len += r > krune3Max ? 2 : 1;
+    stats.max_width = size > stats.max_width ? size : stats.max_width;
+    i += size;
+  }
+  stats.ascii = stats.valid && stats.max_width <= 1;
+  return stats;
+}
+
+}  // namespace scalar
+
+namespace simd {
+
+// Analyze counts lead bytes in the vector validator as it goes and decodes
+// one rune at a time only through the blocks that hold errors.
+text_stats Analyze(span<uint8 const> p);
+
+}  // namespace simd
+
+constexpr text_stats Analyze(span<uint8 const> p) {
+  if (std::is_constant_evaluated() || p.size() < simd::kMinSize) {
+    return scalar::Analyze(p);
+  }
+  return simd::Analyze(p);
+}
+
+constexpr text_stats AnalyzeString(string_view s) {
+  return Analyze({s.Data(), s.Size()});
+}
+
 constexpr bool ValidRune(rune r) {
   if (0 <= r && r < kSurrogateMin) {
     return true;
@@ -332,6 +772,107 @@ constexpr bool ValidRune(rune r) {
   return false;
 }
 
+constexpr string_view ToValidUTF8(string_view s, string& out,
+                                  string_view replacement) {
+  span<uint8 const> const p{s.Data(), s.Size()};
+  if (FirstInvalid(p).second == error_kind::kNone) {
+    return s;
+  }
+
+  // Copy valid runs and replace invalid ones into dst, or only measure the
+  // result if dst is null.
+  auto const repair = [&](uint8* dst) {
+    uint64 n = 0;
+    uint64 i = 0;
+    while (i < p.size()) {
+      auto const [valid, err] = FirstInvalid(p.subspan(i));
+      if (dst != nullptr) {
+        __builtin_memcpy(dst + n, p.data() + i, valid);
+      }
+      n += valid;
+      i += valid;
+      if (err == error_kind::kNone) {
+        break;
+      }
+      while (i < p.size()) {
+        auto const [r, size] = DecodeRune(p.subspan(i));
+        if (r != kRuneError || size != 1) {
+          break;
+        }
+        ++i;
+      }
+      if (dst != nullptr) {
+        __builtin_memcpy(dst + n, replacement.Data(), replacement.Size());
+      }
+      n += replacement.Size();
+    }
+    return n;
+  };
+
+  string repaired;
+  repair(repaired.Init(repair(nullptr)));
+  out = std::move(repaired);
+  return {out.Data(), out.Size()};
+}
+
+constexpr bool stream_validator::Feed(span<uint8 const> p) {
+  if (!ok_) {
+    return false;
+  }
+
+  if (npending_ > 0) {
+    // Complete the held sequence with the first bytes of p.
+    array<uint8, kUTFMax> buf{};
+    uint64 n = 0;
+    for (; n < npending_; ++n) {
+      buf[n] = pending_[n];
+    }
+    uint64 const take = p.size() < kUTFMax - n ? p.size() : kUTFMax - n;
+    for (uint64 i = 0; i < take; ++i) {
+      buf[n + i] = p[i];
+    }
+    span<uint8 const> const head{buf.data(), n + take};
+    if (!FullRune(head)) {
+      // Still incomplete; p fits in the pending bytes.
+      for (uint64 i = 0; i < take; ++i) {
+        pending_[n + i] = p[i];
+      }
+      npending_ += take;
+      return true;
+    }
+    auto const [r, size] = DecodeRune(head);
+    if (r == kRuneError && size == 1) {
+      ok_ = false;
+      return false;
+    }
+    p.remove_prefix(size - npending_);
+    npending_ = 0;
+  }
+
+  // Hold back a last sequence that p cuts short. If the last rune start is
+  // more than kUTFMax-1 bytes from the end, the bulk check rejects p anyway.
+  for (uint64 k = 1; k < kUTFMax && k <= p.size(); ++k) {
+    uint64 const start = p.size() - k;
+    if (RuneStart(p[start])) {
+      if (!FullRune(p.subspan(start))) {
+        for (uint64 i = 0; i < k; ++i) {
+          pending_[i] = p[start + i];
+        }
+        npending_ = k;
+        p.remove_suffix(k);
+      }
+      break;
+    }
+  }
+
+  ok_ = Valid(p);
+  return ok_;
+}
+
+constexpr bool stream_validator::Finish() const {
+  return ok_ && npending_ == 0;
+}
+
 }  // namespace utf8
 }  // namespace unicode
 }  // namespace rflx
\ No newline at end of file
@@ -0,0 +1,92 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+
+#include <thread>
+
+#include "unicode/utf8/utf8.hpp"
+
+namespace rflx {
+namespace unicode {
+namespace utf8 {
+
+namespace {
+
+// Chunks splits p into at most threads pieces of at least kMinParallelChunk
+// bytes. Each cut is moved forward past up to kUTFMax-1 continuation bytes.
+// That puts it where DecodeRune would start a rune when stepping through all
+// of p: a byte that is not a continuation byte always starts one, and the
+// kUTFMax-th of a run of continuation bytes cannot belong to an earlier
+// sequence. Counts and verdicts of the pieces therefore add up to those of p.
+slice<span<uint8 const>> Chunks(span<uint8 const> p, int32 threads) {
+  uint64 n = threads > 0 ? threads : std::thread::hardware_concurrency();
+  if (n == 0) {
+    n = 1;
+  }
+  uint64 size = (p.size() + n - 1) / n;
+  if (size < kMinParallelChunk) {
+    size = kMinParallelChunk;
+  }
+
+  slice<span<uint8 const>> chunks;
+  uint64 begin = 0;
+  while (begin < p.size()) {
+    uint64 end = p.size() - begin > size ? begin + size : p.size();
+    for (uint64 k = 1; k < kUTFMax && end < p.size() && !RuneStart(p[end]);
+         ++k) {
+      ++end;
+    }
+    chunks.push_back(p.subspan(begin, end - begin));
+    begin = end;
+  }
+  return chunks;
+}
+
+// Run calls fn on each chunk of p, on a thread per chunk but the first, and
+// returns the results in chunk order.
+template <typename T, typename Fn>
+slice<T> Run(span<uint8 const> p, int32 threads, Fn fn) {
+  slice<span<uint8 const>> const chunks = Chunks(p, threads);
+  slice<T> results(chunks.size());
+  slice<std::thread> workers;
+  workers.reserve(chunks.size());
+  for (uint64 i = 1; i < chunks.size(); ++i) {
+    workers.emplace_back([&, i] { results[i] = fn(chunks[i]); });
+  }
+  if (!chunks.empty()) {
+    results[0] = fn(chunks[0]);
+  }
+  for (std::thread& w : workers) {
+    w.join();
+  }
+  return results;
+}
+
+}  // namespace
+
+bool ValidParallel(span<uint8 const> p, int32 threads) {
+  // slice<bool> packs bits, which threads cannot write independently.
+  slice<uint8> const valid = Run<uint8>(
+      p, threads, [](span<uint8 const> c) -> uint8 { return Valid(c); });
+  for (uint8 const v : valid) {
+    if (!v) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int64 RuneCountParallel(span<uint8 const> p, int32 threads) {
+  slice<int64> const counts = Run<int64>(
+      p, threads, [](span<uint8 const> c) { return RuneCount(c); });
+  int64 n = 0;
+  for (int64 const c : counts) {
+    n += c;
+  }
+  return n;
+}
+
+}  // namespace utf8
+}  // namespace unicode
+}  // namespace rflx
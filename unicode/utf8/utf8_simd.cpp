@@ -0,0 +1,878 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+
+#include "unicode/utf8/convert_sse42.hpp"
+#include "unicode/utf8/cpu.hpp"
+#include "unicode/utf8/utf8.hpp"
+#include "unicode/utf8/utf8_simd.hpp"
+
+namespace rflx {
+namespace unicode {
+namespace utf8 {
+namespace simd {
+
+namespace {
+
+// Inputs are consumed in blocks of kBlockSize bytes. The last, partial block
+// is copied into a zero padded buffer, which lets the kernels treat a sequence
+// cut by the end of the input like one cut by an ASCII byte.
+constexpr uint64 kBlockSize = 64;
+
+// tally holds counts of bytes in a valid prefix. starts counts the bytes that
+// are not continuation bytes, which is the rune count of the prefix. leads[k]
+// counts the lead bytes of sequences longer than k+1 bytes, that is the bytes
+// from 0xC0, 0xE0 and 0xF0 up; together they are the number of continuation
+// bytes of a prefix that does not end inside a sequence.
+struct tally {
+  int64 starts = 0;
+  int64 leads[kUTFMax - 1] = {};
+
+  // Add adds b to the counts, or takes it away if sign is -1.
+  void Add(uint8 b, int64 sign) {
+    starts += sign * RuneStart(b);
+    leads[0] += sign * (b >= kt2);
+    leads[1] += sign * (b >= kt3);
+    leads[2] += sign * (b >= kt4);
+  }
+};
+
+// Count says what an ErrorBlockFn counts: nothing, starts or leads.
+enum class Count { kNone, kStarts, kLeads };
+
+// ErrorBlockFn returns n if p[0:n] is valid. Otherwise it returns an offset
+// o < n such that p[0:o] is valid, except possibly for a last sequence cut
+// short by o. Unless it counts nothing, it also stores the tally of p[0:o] in
+// *t.
+using ErrorBlockFn = uint64 (*)(uint8 const* p, uint64 n, tally* t);
+
+template <Count kCount>
+uint64 ErrorBlockScalar(uint8 const* p, uint64 n, tally* t) {
+  uint64 i = 0;
+  tally count;
+  while (i < n) {
+    auto const [r, size] = DecodeRune({p + i, n - i});
+    if (r == kRuneError && size == 1) {
+      break;
+    }
+    count.Add(p[i], 1);
+    i += size;
+  }
+  if (kCount != Count::kNone) {
+    *t = count;
+  }
+  return i;
+}
+
+#if RFLX_CPU_X86
+
+// The vector validators classify each pair of adjacent bytes with three
+// 16-entry lookups on the high nibble of the previous byte, the low nibble of
+// the previous byte and the high nibble of the current byte. Each table entry
+// is the set of errors the nibble may take part in, and a pair is invalid if
+// the three sets intersect. Sequences of three and four bytes are completed by
+// requiring continuation bytes exactly where a preceding lead byte expects
+// them. See Keiser and Lemire, "Validating UTF-8 In Less Than One Instruction
+// Per Byte", Software: Practice and Experience 51(5), 2021.
+constexpr uint8 kTooShort = 1 << 0;      // 11______ 0_______, 11______ 11______
+constexpr uint8 kTooLong = 1 << 1;       // 0_______ 10______
+constexpr uint8 kOverlong3 = 1 << 2;     // 11100000 100_____
+constexpr uint8 kTooLarge = 1 << 3;      // 11110100 1001____, 11110100 101_____
+constexpr uint8 kSurrogate = 1 << 4;     // 11101101 101_____
+constexpr uint8 kOverlong2 = 1 << 5;     // 1100000_ 10______
+constexpr uint8 kTooLarge1000 = 1 << 6;  // 11110101+ 1000____
+constexpr uint8 kOverlong4 = 1 << 6;     // 11110000 1000____
+constexpr uint8 kTwoConts = 1 << 7;      // 10______ 10______
+constexpr uint8 kCarry = kTooShort | kTooLong | kTwoConts;
+
+alignas(16) constexpr uint8 kByte1High[16] = {
+    // 0_______ ________
+    kTooLong, kTooLong, kTooLong, kTooLong,
+    kTooLong, kTooLong, kTooLong, kTooLong,
+    // 10______ ________
+    kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+    // 1100____ ________
+    kTooShort | kOverlong2,
+    // 1101____ ________
+    kTooShort,
+    // 1110____ ________
+    kTooShort | kOverlong3 | kSurrogate,
+    // 1111____ ________
+    kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,
+};
+
+alignas(16) constexpr uint8 kByte1Low[16] = {
+    // ____0000 ________
+    kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+    // ____0001 ________
+    kCarry | kOverlong2,
+    // ____001_ ________
+    kCarry,
+    kCarry,
+    // ____0100 ________
+    kCarry | kTooLarge,
+    // ____0101 ________
+    kCarry | kTooLarge | kTooLarge1000,
+    // ____011_ ________
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    // ____1___ ________
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    // ____1101 ________
+    kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+};
+
+alignas(16) constexpr uint8 kByte2High[16] = {
+    // ________ 0_______
+    kTooShort, kTooShort, kTooShort, kTooShort,
+    kTooShort, kTooShort, kTooShort, kTooShort,
+    // ________ 1000____
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+    // ________ 1001____
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+    // ________ 101_____
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    // ________ 11______
+    kTooShort, kTooShort, kTooShort, kTooShort,
+};
+
+// kLeads[k] is 1 for the high nibbles of the bytes counted by tally::leads[k].
+alignas(16) constexpr uint8 kLeads[kUTFMax - 1][16] = {
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1},
+};
+
+// A block ending in one of these positions with a byte at least this large
+// has a sequence running into the next block.
+alignas(32) constexpr uint8 kIncompleteMax[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+};
+
+// Fail returns from a vector kernel that found an error in the block at i.
+// The kernels run one block past a multiple of kBlockSize to flush a sequence
+// cut by the end of the input; an error found in that empty block belongs to
+// the last byte.
+template <Count kCount>
+uint64 Fail(uint8 const* p, uint64 n, uint64 i, tally count, tally* t) {
+  if (i == n) {
+    --i;
+    count.Add(p[i], -1);
+  }
+  if (kCount != Count::kNone) {
+    *t = count;
+  }
+  return i;
+}
+
+// Pass returns from a vector kernel that accepted all of p[0:n]. count
+// includes the zero padding of the last block, which reads as ASCII.
+template <Count kCount>
+uint64 Pass(uint64 n, tally count, tally* t) {
+  if (kCount != Count::kNone) {
+    count.starts -= static_cast<int64>(kBlockSize - n % kBlockSize);
+    *t = count;
+  }
+  return n;
+}
+
+// SSE4.2 kernel: four 16 byte vectors per block.
+
+template <int N>
+RFLX_TARGET_SSE42 __m128i PrevSSE42(__m128i input, __m128i prev) {
+  return _mm_alignr_epi8(input, prev, 16 - N);
+}
+
+RFLX_TARGET_SSE42 __m128i CheckSSE42(__m128i input, __m128i prev) {
+  __m128i const nibble = _mm_set1_epi8(0x0F);
+  __m128i const prev1 = PrevSSE42<1>(input, prev);
+  __m128i const byte_1_high = _mm_shuffle_epi8(
+      _mm_load_si128(reinterpret_cast<__m128i const*>(kByte1High)),
+      _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+  __m128i const byte_1_low = _mm_shuffle_epi8(
+      _mm_load_si128(reinterpret_cast<__m128i const*>(kByte1Low)),
+      _mm_and_si128(prev1, nibble));
+  __m128i const byte_2_high = _mm_shuffle_epi8(
+      _mm_load_si128(reinterpret_cast<__m128i const*>(kByte2High)),
+      _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+  __m128i const special =
+      _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+  // Only 111_____ and 1111____ survive these subtractions with the top bit
+  // set: the bytes two and three positions later must be continuations.
+  __m128i const third = _mm_subs_epu8(PrevSSE42<2>(input, prev),
+                                      _mm_set1_epi8(char(0xE0 - 0x80)));
+  __m128i const fourth = _mm_subs_epu8(PrevSSE42<3>(input, prev),
+                                       _mm_set1_epi8(char(0xF0 - 0x80)));
+  __m128i const must23 = _mm_and_si128(_mm_or_si128(third, fourth),
+                                       _mm_set1_epi8(char(0x80)));
+  return _mm_xor_si128(must23, special);
+}
+
+RFLX_TARGET_SSE42 __m128i IncompleteSSE42(__m128i input) {
+  return _mm_subs_epu8(
+      input,
+      _mm_load_si128(reinterpret_cast<__m128i const*>(kIncompleteMax + 16)));
+}
+
+RFLX_TARGET_SSE42 int64 StartsSSE42(__m128i input) {
+  // Continuation bytes are the signed values below -64.
+  return __builtin_popcount(
+      _mm_movemask_epi8(_mm_cmpgt_epi8(input, _mm_set1_epi8(-65))));
+}
+
+// leads_sse42 counts the lead bytes of a block in byte lanes, one vector for
+// each of tally::leads, and adds them up in 64 bit lanes across blocks.
+struct leads_sse42 {
+  __m128i block[kUTFMax - 1];
+  __m128i total[kUTFMax - 1];
+};
+
+RFLX_TARGET_SSE42 __m128i LeadsSSE42(__m128i high, int k) {
+  return _mm_shuffle_epi8(
+      _mm_load_si128(reinterpret_cast<__m128i const*>(kLeads[k])), high);
+}
+
+RFLX_TARGET_SSE42 void AddLeadsSSE42(__m128i input, leads_sse42* l) {
+  __m128i const high =
+      _mm_and_si128(_mm_srli_epi16(input, 4), _mm_set1_epi8(0x0F));
+  l->block[0] = _mm_add_epi8(l->block[0], LeadsSSE42(high, 0));
+  l->block[1] = _mm_add_epi8(l->block[1], LeadsSSE42(high, 1));
+  l->block[2] = _mm_add_epi8(l->block[2], LeadsSSE42(high, 2));
+}
+
+// SumSSE42 adds up the 64 bit lanes of v.
+RFLX_TARGET_SSE42 int64 SumSSE42(__m128i v) {
+  return _mm_cvtsi128_si64(v) + _mm_extract_epi64(v, 1);
+}
+
+// CommitSSE42 moves the block counts into the totals.
+RFLX_TARGET_SSE42 void CommitSSE42(leads_sse42* l) {
+  __m128i const zero = _mm_setzero_si128();
+  l->total[0] = _mm_add_epi64(l->total[0], _mm_sad_epu8(l->block[0], zero));
+  l->total[1] = _mm_add_epi64(l->total[1], _mm_sad_epu8(l->block[1], zero));
+  l->total[2] = _mm_add_epi64(l->total[2], _mm_sad_epu8(l->block[2], zero));
+  l->block[0] = l->block[1] = l->block[2] = zero;
+}
+
+template <Count kCount>
+RFLX_TARGET_SSE42 uint64 ErrorBlockSSE42(uint8 const* p, uint64 n, tally* t) {
+  __m128i prev = _mm_setzero_si128();
+  __m128i incomplete = _mm_setzero_si128();
+  alignas(16) uint8 tail[kBlockSize] = {};
+  tally count;
+  leads_sse42 leads = {};
+
+  uint64 i = 0;
+  for (; i <= n; i += kBlockSize) {
+    uint8 const* block = p + i;
+    if (n - i < kBlockSize) {
+      if (n > i) {
+        __builtin_memcpy(tail, block, n - i);
+      }
+      block = tail;
+    }
+    __m128i const in0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(block));
+    __m128i const in1 =
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(block + 16));
+    __m128i const in2 =
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(block + 32));
+    __m128i const in3 =
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(block + 48));
+
+    __m128i error;
+    int64 block_starts = kBlockSize;
+    __m128i const any =
+        _mm_or_si128(_mm_or_si128(in0, in1), _mm_or_si128(in2, in3));
+    if (_mm_movemask_epi8(any) == 0) {
+      error = incomplete;
+      incomplete = _mm_setzero_si128();
+    } else {
+      error = _mm_or_si128(
+          _mm_or_si128(CheckSSE42(in0, prev), CheckSSE42(in1, in0)),
+          _mm_or_si128(CheckSSE42(in2, in1), CheckSSE42(in3, in2)));
+      incomplete = IncompleteSSE42(in3);
+      if (kCount == Count::kStarts) {
+        block_starts = StartsSSE42(in0) + StartsSSE42(in1) +
+                       StartsSSE42(in2) + StartsSSE42(in3);
+      } else if (kCount == Count::kLeads) {
+        AddLeadsSSE42(in0, &leads);
+        AddLeadsSSE42(in1, &leads);
+        AddLeadsSSE42(in2, &leads);
+        AddLeadsSSE42(in3, &leads);
+      }
+    }
+    prev = in3;
+
+    if (!_mm_testz_si128(error, error)) {
+      break;
+    }
+    count.starts += block_starts;
+    if (kCount == Count::kLeads) {
+      CommitSSE42(&leads);
+    }
+  }
+
+  if (kCount == Count::kLeads) {
+    count.leads[0] = SumSSE42(leads.total[0]);
+    count.leads[1] = SumSSE42(leads.total[1]);
+    count.leads[2] = SumSSE42(leads.total[2]);
+  }
+  return i <= n ? Fail<kCount>(p, n, i, count, t) : Pass<kCount>(n, count, t);
+}
+
+// AVX2 kernel: two 32 byte vectors per block.
+
+template <int N>
+RFLX_TARGET_AVX2 __m256i PrevAVX2(__m256i input, __m256i prev) {
+  return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21),
+                            16 - N);
+}
+
+RFLX_TARGET_AVX2 __m256i Table(uint8 const* table) {
+  return _mm256_broadcastsi128_si256(
+      _mm_load_si128(reinterpret_cast<__m128i const*>(table)));
+}
+
+RFLX_TARGET_AVX2 __m256i CheckAVX2(__m256i input, __m256i prev) {
+  __m256i const nibble = _mm256_set1_epi8(0x0F);
+  __m256i const prev1 = PrevAVX2<1>(input, prev);
+  __m256i const byte_1_high =
+      _mm256_shuffle_epi8(Table(kByte1High),
+                          _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+  __m256i const byte_1_low =
+      _mm256_shuffle_epi8(Table(kByte1Low), _mm256_and_si256(prev1, nibble));
+  __m256i const byte_2_high =
+      _mm256_shuffle_epi8(Table(kByte2High),
+                          _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+  __m256i const special = _mm256_and_si256(
+      _mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+  __m256i const third = _mm256_subs_epu8(PrevAVX2<2>(input, prev),
+                                         _mm256_set1_epi8(char(0xE0 - 0x80)));
+  __m256i const fourth = _mm256_subs_epu8(PrevAVX2<3>(input, prev),
+                                          _mm256_set1_epi8(char(0xF0 - 0x80)));
+  __m256i const must23 = _mm256_and_si256(_mm256_or_si256(third, fourth),
+                                          _mm256_set1_epi8(char(0x80)));
+  return _mm256_xor_si256(must23, special);
+}
+
+RFLX_TARGET_AVX2 __m256i IncompleteAVX2(__m256i input) {
+  return _mm256_subs_epu8(
+      input, _mm256_load_si256(reinterpret_cast<__m256i const*>(kIncompleteMax)));
+}
+
+RFLX_TARGET_AVX2 int64 StartsAVX2(__m256i input) {
+  return __builtin_popcount(
+      _mm256_movemask_epi8(_mm256_cmpgt_epi8(input, _mm256_set1_epi8(-65))));
+}
+
+struct leads_avx2 {
+  __m256i block[kUTFMax - 1];
+  __m256i total[kUTFMax - 1];
+};
+
+RFLX_TARGET_AVX2 void AddLeadsAVX2(__m256i input, leads_avx2* l) {
+  __m256i const high =
+      _mm256_and_si256(_mm256_srli_epi16(input, 4), _mm256_set1_epi8(0x0F));
+  l->block[0] = _mm256_add_epi8(l->block[0],
+                                _mm256_shuffle_epi8(Table(kLeads[0]), high));
+  l->block[1] = _mm256_add_epi8(l->block[1],
+                                _mm256_shuffle_epi8(Table(kLeads[1]), high));
+  l->block[2] = _mm256_add_epi8(l->block[2],
+                                _mm256_shuffle_epi8(Table(kLeads[2]), high));
+}
+
+RFLX_TARGET_AVX2 int64 SumAVX2(__m256i v) {
+  __m128i const half = _mm_add_epi64(_mm256_castsi256_si128(v),
+                                     _mm256_extracti128_si256(v, 1));
+  return _mm_cvtsi128_si64(half) + _mm_extract_epi64(half, 1);
+}
+
+RFLX_TARGET_AVX2 void CommitAVX2(leads_avx2* l) {
+  __m256i const zero = _mm256_setzero_si256();
+  l->total[0] =
+      _mm256_add_epi64(l->total[0], _mm256_sad_epu8(l->block[0], zero));
+  l->total[1] =
+      _mm256_add_epi64(l->total[1], _mm256_sad_epu8(l->block[1], zero));
+  l->total[2] =
+      _mm256_add_epi64(l->total[2], _mm256_sad_epu8(l->block[2], zero));
+  l->block[0] = l->block[1] = l->block[2] = zero;
+}
+
+template <Count kCount>
+RFLX_TARGET_AVX2 uint64 ErrorBlockAVX2(uint8 const* p, uint64 n, tally* t) {
+  __m256i prev = _mm256_setzero_si256();
+  __m256i incomplete = _mm256_setzero_si256();
+  alignas(32) uint8 tail[kBlockSize] = {};
+  tally count;
+  leads_avx2 leads = {};
+
+  uint64 i = 0;
+  for (; i <= n; i += kBlockSize) {
+    uint8 const* block = p + i;
+    if (n - i < kBlockSize) {
+      if (n > i) {
+        __builtin_memcpy(tail, block, n - i);
+      }
+      block = tail;
+    }
+    __m256i const in0 =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(block));
+    __m256i const in1 =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(block + 32));
+
+    __m256i error;
+    int64 block_starts = kBlockSize;
+    if (_mm256_movemask_epi8(_mm256_or_si256(in0, in1)) == 0) {
+      error = incomplete;
+      incomplete = _mm256_setzero_si256();
+    } else {
+      error = _mm256_or_si256(CheckAVX2(in0, prev), CheckAVX2(in1, in0));
+      incomplete = IncompleteAVX2(in1);
+      if (kCount == Count::kStarts) {
+        block_starts = StartsAVX2(in0) + StartsAVX2(in1);
+      } else if (kCount == Count::kLeads) {
+        AddLeadsAVX2(in0, &leads);
+        AddLeadsAVX2(in1, &leads);
+      }
+    }
+    prev = in1;
+
+    if (!_mm256_testz_si256(error, error)) {
+      break;
+    }
+    count.starts += block_starts;
+    if (kCount == Count::kLeads) {
+      CommitAVX2(&leads);
+    }
+  }
+
+  if (kCount == Count::kLeads) {
+    count.leads[0] = SumAVX2(leads.total[0]);
+    count.leads[1] = SumAVX2(leads.total[1]);
+    count.leads[2] = SumAVX2(leads.total[2]);
+  }
+  return i <= n ? Fail<kCount>(p, n, i, count, t) : Pass<kCount>(n, count, t);
+}
+
+// Bulk decoding: each step looks at the next 16 bytes.
+
+RFLX_TARGET_SSE42 void StoreRunes(rune* out, __m128i runes) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out), runes);
+}
+
+RFLX_TARGET_SSE42 pair<int64, int64> DecodeRunesSSE42(span<uint8 const> p,
+                                                     span<rune> out) {
+  uint64 const n = p.size();
+  uint64 const m = out.size();
+  uint64 i = 0;
+  uint64 k = 0;
+  while (i < n && k < m) {
+    // A window that starts with a four byte sequence fits no block shape.
+    if (n - i >= 16 && m - k >= 16 && p[i] < kt4) {
+      __m128i const input =
+          _mm_loadu_si128(reinterpret_cast<__m128i const*>(p.data() + i));
+      uint32 const high = _mm_movemask_epi8(input);
+      if ((high & 1) == 0) {
+        // Widen all 16 bytes; only the leading ASCII ones are kept.
+        rune* const o = out.data() + k;
+        StoreRunes(o, _mm_cvtepu8_epi32(input));
+        StoreRunes(o + 4, _mm_cvtepu8_epi32(_mm_srli_si128(input, 4)));
+        StoreRunes(o + 8, _mm_cvtepu8_epi32(_mm_srli_si128(input, 8)));
+        StoreRunes(o + 12, _mm_cvtepu8_epi32(_mm_srli_si128(input, 12)));
+        uint64 const ascii = high == 0 ? 16 : __builtin_ctz(high);
+        i += ascii;
+        k += ascii;
+        continue;
+      }
+      __m128i runes;
+      if (DecodeTwoByteSSE42(input, &runes)) {
+        StoreRunes(out.data() + k, _mm_cvtepu16_epi32(runes));
+        StoreRunes(out.data() + k + 4,
+                   _mm_cvtepu16_epi32(_mm_srli_si128(runes, 8)));
+        i += 16;
+        k += 8;
+        continue;
+      }
+      if (DecodeThreeByteSSE42(input, &runes)) {
+        StoreRunes(out.data() + k, runes);
+        i += 12;
+        k += 4;
+        continue;
+      }
+    }
+    // Text of no block shape, such as four byte sequences, stays scalar to
+    // the end of the window or the next ASCII byte, so that a run of it
+    // does not redo the block checks for every rune.
+    uint64 const end = n - i > 16 ? i + 16 : n;
+    do {
+      auto const [r, size] = DecodeRune(p.subspan(i));
+      out[k] = r;
+      ++k;
+      i += size;
+    } while (i < end && k < m && p[i] >= kRuneSelf);
+  }
+  return {k, i};
+}
+
+// Bulk encoding: each step looks at the next 16 runes.
+
+RFLX_TARGET_SSE42 __m128i LoadRunes(rune const* p) {
+  return _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+}
+
+// WidthsSSE42 returns the encoded length of each rune.
+RFLX_TARGET_SSE42 __m128i WidthsSSE42(__m128i runes) {
+  // After clamping, the signed comparisons below are exact. Each true
+  // comparison is -1.
+  __m128i const r = _mm_min_epu32(runes, _mm_set1_epi32(kMaxRune + 1));
+  __m128i w = _mm_set1_epi32(1);
+  w = _mm_sub_epi32(w, _mm_cmpgt_epi32(r, _mm_set1_epi32(krune1Max)));
+  w = _mm_sub_epi32(w, _mm_cmpgt_epi32(r, _mm_set1_epi32(krune2Max)));
+  w = _mm_sub_epi32(w, _mm_cmpgt_epi32(r, _mm_set1_epi32(krune3Max)));
+  // Invalid runes are encoded as the three byte RuneError.
+  return _mm_add_epi32(w, _mm_cmpgt_epi32(r, _mm_set1_epi32(kMaxRune)));
+}
+
+RFLX_TARGET_SSE42 int64 EncodedLenSSE42(span<rune const> p) {
+  uint64 const n = p.size();
+  int64 total = 0;
+  uint64 i = 0;
+  while (n - i >= 4) {
+    // Lanes grow by at most 4 per step; flush them well before they overflow.
+    uint64 const end = n - i > (uint64{4} << 24) ? i + (uint64{4} << 24) : n;
+    __m128i sum = _mm_setzero_si128();
+    for (; end - i >= 4; i += 4) {
+      sum = _mm_add_epi32(sum, WidthsSSE42(LoadRunes(p.data() + i)));
+    }
+    sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+    sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+    total += _mm_cvtsi128_si32(sum);
+  }
+  return total + scalar::EncodedLen(p.subspan(i));
+}
+
+// TwoByteLanesSSE42 returns lead | continuation << 8 for each two byte rune.
+RFLX_TARGET_SSE42 __m128i TwoByteLanesSSE42(__m128i r) {
+  __m128i const lead = _mm_or_si128(_mm_srli_epi32(r, 6), _mm_set1_epi32(kt2));
+  __m128i const cont = _mm_or_si128(_mm_and_si128(r, _mm_set1_epi32(kmaskx)),
+                                    _mm_set1_epi32(ktx));
+  return _mm_or_si128(lead, _mm_slli_epi32(cont, 8));
+}
+
+// EncodeTwoByteSSE42 encodes 8 runes into 16 bytes if they all take two.
+RFLX_TARGET_SSE42 bool EncodeTwoByteSSE42(__m128i r0, __m128i r1,
+                                          uint8* out) {
+  __m128i const ok = _mm_and_si128(InRangeSSE42(r0, krune1Max + 1, krune2Max),
+                                   InRangeSSE42(r1, krune1Max + 1, krune2Max));
+  if (_mm_movemask_epi8(ok) != 0xFFFF) {
+    return false;
+  }
+  _mm_storeu_si128(
+      reinterpret_cast<__m128i*>(out),
+      _mm_packus_epi32(TwoByteLanesSSE42(r0), TwoByteLanesSSE42(r1)));
+  return true;
+}
+
+RFLX_TARGET_SSE42 pair<int64, int64> EncodeRunesSSE42(span<rune const> p,
+                                                     span<uint8> out) {
+  uint64 const n = p.size();
+  uint64 const m = out.size();
+  uint64 i = 0;
+  uint64 k = 0;
+  while (i < n) {
+    // The first rune picks the one block shape the window can have; a
+    // window that starts with a four byte rune has none.
+    if (n - i >= 16 && m - k >= 16 && p[i] <= krune3Max) {
+      rune const* const r = p.data() + i;
+      __m128i const r0 = LoadRunes(r);
+      __m128i const r1 = LoadRunes(r + 4);
+      if (p[i] < kRuneSelf) {
+        // Narrow all 16 runes, clamped to a byte so that larger runes show
+        // up as bytes with the top bit set; only the leading ASCII ones are
+        // kept.
+        __m128i const ff = _mm_set1_epi32(0xFF);
+        __m128i const bytes = _mm_packus_epi16(
+            _mm_packus_epi32(_mm_min_epu32(r0, ff), _mm_min_epu32(r1, ff)),
+            _mm_packus_epi32(_mm_min_epu32(LoadRunes(r + 8), ff),
+                             _mm_min_epu32(LoadRunes(r + 12), ff)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out.data() + k), bytes);
+        uint32 const high = _mm_movemask_epi8(bytes);
+        uint64 const ascii = high == 0 ? 16 : __builtin_ctz(high);
+        i += ascii;
+        k += ascii;
+        continue;
+      }
+      if (p[i] <= krune2Max) {
+        if (EncodeTwoByteSSE42(r0, r1, out.data() + k)) {
+          i += 8;
+          k += 16;
+          continue;
+        }
+      } else if (EncodeThreeByteSSE42(r0, out.data() + k)) {
+        i += 4;
+        k += 12;
+        continue;
+      }
+    }
+    // Runes of no block shape are encoded scalar to the end of the window,
+    // so that a run of them does not redo the block checks for every rune.
+    uint64 const end = n - i < 16 ? n : i + 16;
+    // Near the end of out, only the runes that fit are encoded.
+    if (m - k < kUTFMax * (end - i)) {
+      auto const [runes, bytes] =
+          scalar::EncodeRunes(p.subspan(i), out.subspan(k));
+      return {i + runes, k + bytes};
+    }
+    for (; i < end; ++i) {
+      k += EncodeRune({out.data() + k, kUTFMax}, p[i]);
+    }
+  }
+  return {i, k};
+}
+
+#endif  // RFLX_CPU_X86
+
+// ErrorScanStart returns where to look for the first error after a kernel
+// run over p[begin:] stopped at o: the last byte before o that is not a
+// continuation byte and might start the sequence o cut, or o itself.
+uint64 ErrorScanStart(span<uint8 const> p, uint64 begin, uint64 o) {
+  for (uint64 j = o; j > begin && o - j < kUTFMax - 1; --j) {
+    if (RuneStart(p[j - 1])) {
+      return j - 1;
+    }
+  }
+  return o;
+}
+
+// Best returns the widest code path the running CPU supports.
+target Best() {
+  if (cpu::HasAVX2()) {
+    return target::kAVX2;
+  }
+  if (cpu::HasSSE42()) {
+    return target::kSSE42;
+  }
+  return target::kScalar;
+}
+
+template <Count kCount>
+ErrorBlockFn SelectErrorBlock(target t) {
+#if RFLX_CPU_X86
+  if (t == target::kAVX2) {
+    return ErrorBlockAVX2<kCount>;
+  }
+  if (t == target::kSSE42) {
+    return ErrorBlockSSE42<kCount>;
+  }
+#endif
+  return ErrorBlockScalar<kCount>;
+}
+
+bool ValidWith(ErrorBlockFn fn, span<uint8 const> p) {
+  return fn(p.data(), p.size(), nullptr) == p.size();
+}
+
+pair<int64, error_kind> FirstInvalidWith(ErrorBlockFn fn, span<uint8 const> p) {
+  uint64 const o = fn(p.data(), p.size(), nullptr);
+  if (o == p.size()) {
+    return {o, error_kind::kNone};
+  }
+  uint64 const start = ErrorScanStart(p, 0, o);
+  auto const [offset, error] = scalar::FirstInvalid(p.subspan(start));
+  return {start + offset, error};
+}
+
+int64 RuneCountWith(ErrorBlockFn fn, span<uint8 const> p) {
+  uint64 const n = p.size();
+  int64 count = 0;
+  for (uint64 i = 0; i < n;) {
+    tally t;
+    uint64 const o = i + fn(p.data() + i, n - i, &t);
+    count += t.starts;
+    if (o == n) {
+      break;
+    }
+
+    // Decode one rune at a time through the block that held the error,
+    // counting each invalid byte as one rune.
+    uint64 const start = ErrorScanStart(p, i, o);
+    count -= static_cast<int64>(start < o);
+    i = start;
+    uint64 const resume = o + kBlockSize < n ? o + kBlockSize : n;
+    while (i < resume) {
+      i += DecodeRune(p.subspan(i)).second;
+      ++count;
+    }
+  }
+  return count;
+}
+
+text_stats AnalyzeWith(ErrorBlockFn fn, span<uint8 const> p) {
+  uint64 const n = p.size();
+  text_stats stats;
+  stats.first_invalid = n;
+  int64 leads[kUTFMax - 1] = {};
+  // pairs counts the runes that take two UTF-16 units.
+  int64 pairs = 0;
+  for (uint64 i = 0; i < n;) {
+    tally t;
+    uint64 const o = i + fn(p.data() + i, n - i, &t);
+    // The valid runs end at rune boundaries, so every continuation byte in
+    // them belongs to a counted lead byte.
+    uint64 end = o;
+    if (o != n) {
+      // As in RuneCount, but the lead byte of a sequence cut at o comes out
+      // of the counts.
+      end = ErrorScanStart(p, i, o);
+      if (end < o) {
+        t.Add(p[end], -1);
+      }
+    }
+    stats.runes += end - i;
+    for (uint64 k = 0; k < kUTFMax - 1; ++k) {
+      leads[k] += t.leads[k];
+      stats.runes -= t.leads[k];
+    }
+    pairs += t.leads[kUTFMax - 2];
+    if (o == n) {
+      break;
+    }
+
+    if (stats.valid) {
+      auto const [offset, error] = scalar::FirstInvalid(p.subspan(end));
+      stats.valid = false;
+      stats.first_invalid = end + offset;
+      stats.error = error;
+    }
+    i = end;
+    uint64 const resume = o + kBlockSize < n ? o + kBlockSize : n;
+    while (i < resume) {
+      auto const [r, size] = DecodeRune(p.subspan(i));
+      ++stats.runes;
+      pairs += r > krune3Max;
+      stats.max_width = size > stats.max_width ? size : stats.max_width;
+      i += size;
+    }
+  }
+
+  stats.utf16_len = stats.runes + pairs;
+  int8 width = stats.runes > 0;
+  for (int64 const count : leads) {
+    width += count > 0;
+  }
+  stats.max_width = width > stats.max_width ? width : stats.max_width;
+  stats.ascii = stats.valid && stats.max_width <= 1;
+  return stats;
+}
+
+}  // namespace
+
+bool Supported(target t) {
+  switch (t) {
+    case target::kScalar:
+      return true;
+    case target::kSSE42:
+      return cpu::HasSSE42();
+    case target::kAVX2:
+      return cpu::HasAVX2();
+  }
+  return false;
+}
+
+bool Valid(span<uint8 const> p) {
+  static ErrorBlockFn const fn = SelectErrorBlock<Count::kNone>(Best());
+  return ValidWith(fn, p);
+}
+
+bool Valid(span<uint8 const> p, target t) {
+  return ValidWith(SelectErrorBlock<Count::kNone>(t), p);
+}
+
+pair<int64, error_kind> FirstInvalid(span<uint8 const> p) {
+  static ErrorBlockFn const fn = SelectErrorBlock<Count::kNone>(Best());
+  return FirstInvalidWith(fn, p);
+}
+
+pair<int64, error_kind> FirstInvalid(span<uint8 const> p, target t) {
+  return FirstInvalidWith(SelectErrorBlock<Count::kNone>(t), p);
+}
+
+int64 RuneCount(span<uint8 const> p) {
+  static ErrorBlockFn const fn = SelectErrorBlock<Count::kStarts>(Best());
+  return RuneCountWith(fn, p);
+}
+
+int64 RuneCount(span<uint8 const> p, target t) {
+  return RuneCountWith(SelectErrorBlock<Count::kStarts>(t), p);
+}
+
+text_stats Analyze(span<uint8 const> p) {
+  static ErrorBlockFn const fn = SelectErrorBlock<Count::kLeads>(Best());
+  return AnalyzeWith(fn, p);
+}
+
+text_stats Analyze(span<uint8 const> p, target t) {
+  return AnalyzeWith(SelectErrorBlock<Count::kLeads>(t), p);
+}
+
+pair<int64, int64> DecodeRunes(span<uint8 const> p, span<rune> out) {
+  static target const t = Best();
+  return DecodeRunes(p, out, t);
+}
+
+pair<int64, int64> DecodeRunes(span<uint8 const> p, span<rune> out,
+                               target t) {
+#if RFLX_CPU_X86
+  if (t != target::kScalar) {
+    return DecodeRunesSSE42(p, out);
+  }
+#endif
+  return scalar::DecodeRunes(p, out);
+}
+
+int64 EncodedLen(span<rune const> p) {
+  static target const t = Best();
+  return EncodedLen(p, t);
+}
+
+int64 EncodedLen(span<rune const> p, target t) {
+#if RFLX_CPU_X86
+  if (t != target::kScalar) {
+    return EncodedLenSSE42(p);
+  }
+#endif
+  return scalar::EncodedLen(p);
+}
+
+pair<int64, int64> EncodeRunes(span<rune const> p, span<uint8> out) {
+  static target const t = Best();
+  return EncodeRunes(p, out, t);
+}
+
+pair<int64, int64> EncodeRunes(span<rune const> p, span<uint8> out,
+                               target t) {
+#if RFLX_CPU_X86
+  if (t != target::kScalar) {
+    return EncodeRunesSSE42(p, out);
+  }
+#endif
+  return scalar::EncodeRunes(p, out);
+}
+
+}  // namespace simd
+}  // namespace utf8
+}  // namespace unicode
+}  // namespace rflx
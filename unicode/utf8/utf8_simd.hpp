@@ -0,0 +1,41 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+#pragma once
+
+// Per-target entry points of the vectorized functions of utf8.hpp, so that
+// tests and benchmarks can run a code path the running CPU would not pick.
+// The library itself selects the widest supported path once per function.
+
+#include "types.hpp"
+#include "unicode/utf8/utf8.hpp"
+
+namespace rflx {
+namespace unicode {
+namespace utf8 {
+namespace simd {
+
+// target names a code path of the vectorized functions.
+enum class target { kScalar, kSSE42, kAVX2 };
+
+// Supported reports whether the running CPU can run the code path t.
+bool Supported(target t);
+
+// Each function below is the simd function of the same name run on the
+// widest code path up to t, which must be supported. DecodeRunes,
+// EncodedLen and EncodeRunes have no AVX2 path and run the SSE4.2 one.
+bool Valid(span<uint8 const> p, target t);
+pair<int64, error_kind> FirstInvalid(span<uint8 const> p, target t);
+int64 RuneCount(span<uint8 const> p, target t);
+text_stats Analyze(span<uint8 const> p, target t);
+pair<int64, int64> DecodeRunes(span<uint8 const> p, span<rune> out,
+                               target t);
+int64 EncodedLen(span<rune const> p, target t);
+pair<int64, int64> EncodeRunes(span<rune const> p, span<uint8> out,
+                               target t);
+
+}  // namespace simd
+}  // namespace utf8
+}  // namespace unicode
+}  // namespace rflx
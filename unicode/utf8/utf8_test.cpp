@@ -1,7 +1,12 @@
 #include "unicode/utf8/utf8.hpp"
 
+#include <random>
+
 #include "gtest/gtest.h"
 #include "types.hpp"
+#include "unicode/utf8/builder.hpp"
+#include "unicode/utf8/literal.hpp"
+#include "unicode/utf8/utf8_simd.hpp"
 
 namespace rflx {
 namespace unicode {
@@ -185,6 +190,33 @@ array<ValidTest, 18> validTests = {{
      false},  // U+DFFF low surrogate (sic)
 }};
 
+struct FirstInvalidTest {
+  string_view in;
+  int64 offset;
+  error_kind error;
+};
+
+array<FirstInvalidTest, 14> firstinvalidtests = {{
+    {reinterpret_cast<const uint8*>(""), 0, error_kind::kNone},
+    {reinterpret_cast<const uint8*>("abc"), 3, error_kind::kNone},
+    {reinterpret_cast<const uint8*>("☺☻☹"), 9, error_kind::kNone},
+    {reinterpret_cast<const uint8*>("a\x80" "b"), 1, error_kind::kBadLeadByte},
+    {reinterpret_cast<const uint8*>("ab\xff"), 2, error_kind::kBadLeadByte},
+    {reinterpret_cast<const uint8*>("\xc0\x80"), 0, error_kind::kOverlong},
+    {reinterpret_cast<const uint8*>("ab\xe0\x80\x80"),
+     2, error_kind::kOverlong},
+    {reinterpret_cast<const uint8*>("\xf0\x8f\xbf\xbf"),
+     0, error_kind::kOverlong},
+    {reinterpret_cast<const uint8*>("\xed\xa0\x80"), 0, error_kind::kSurrogate},
+    {reinterpret_cast<const uint8*>("a\xe2\x82"), 1, error_kind::kTruncated},
+    {reinterpret_cast<const uint8*>("\xe2\x82" "a"), 0, error_kind::kTruncated},
+    {reinterpret_cast<const uint8*>("☺\xc2"), 3, error_kind::kTruncated},
+    {reinterpret_cast<const uint8*>("\xf4\x90\x80\x80"),
+     0, error_kind::kOutOfRange},
+    {reinterpret_cast<const uint8*>("\xf5\x80\x80\x80"),
+     0, error_kind::kOutOfRange},
+}};
+
 struct ValidRuneTest {
   rune r;
   bool ok;
@@ -243,6 +275,52 @@ TEST(utf8, TestEncodeRune) {
   }
 }
 
+TEST(utf8, TestEncodeRunes) {
+  slice<rune> runes;
+  for (Utf8Map const& m : utf8map) {
+    for (int32 i = 0; i < 16; ++i) {
+      runes.push_back(m.r);
+    }
+  }
+  for (rune const r : {rune{0xD800}, rune{0xDFFF}, kMaxRune + 1, ~rune{0}}) {
+    runes.push_back(r);
+  }
+  for (Utf8Map const& m : utf8map) {
+    runes.push_back(m.r);
+  }
+
+  for (uint64 start = 0; start < 64; ++start) {
+    span<rune const> const p =
+        span<rune const>{runes.data(), runes.size()}.subspan(start);
+    slice<uint8> want;
+    for (rune const r : p) {
+      array<uint8, kUTFMax> buf;
+      int32 const n = EncodeRune({buf.data(), buf.size()}, r);
+      want.insert(want.end(), buf.data(), buf.data() + n);
+    }
+    if (EncodedLen(p) != static_cast<int64>(want.size())) {
+      FAIL() << "EncodedLen(runes[" << start << ":]) = " << EncodedLen(p)
+             << ", want " << want.size();
+    }
+    for (uint64 room : {want.size(), want.size() / 2, uint64{17}}) {
+      slice<uint8> out(room);
+      slice<uint8> scalar_out(room);
+      auto const got = EncodeRunes(p, {out.data(), out.size()});
+      auto const want_counts =
+          scalar::EncodeRunes(p, {scalar_out.data(), scalar_out.size()});
+      if (got != want_counts) {
+        FAIL() << "EncodeRunes(runes[" << start << ":], " << room << ") = "
+               << got.first << ", " << got.second << ", want "
+               << want_counts.first << ", " << want_counts.second;
+      }
+      if (!std::equal(out.begin(), out.begin() + got.second, want.begin())) {
+        FAIL() << "EncodeRunes(runes[" << start << ":], " << room
+               << ") wrote the wrong bytes";
+      }
+    }
+  }
+}
+
 TEST(utf8, TestDecodeRune) {
   for (Utf8Map const& m : utf8map) {
     {
@@ -350,6 +428,52 @@ TEST(utf8, TestDecodeSurrogateRune) {
   }
 }
 
+constexpr uint8 kDFAJapanese[] = {0xE6, 0x97, 0xA5};
+static_assert(DecodeRune<dfa_decoder>(kDFAJapanese) ==
+              pair<rune, int8>{0x65E5, 3});
+static_assert(DecodeRune<dfa_decoder>({kDFAJapanese, 2}) ==
+              pair<rune, int8>{kRuneError, 1});
+static_assert(DecodeRune<dfa_decoder>({kDFAJapanese, 0}) ==
+              pair<rune, int8>{kRuneError, 0});
+
+TEST(utf8, TestDFADecoder) {
+  for (Utf8Map const& m : utf8map) {
+    string_view const s{m.str.Data(), m.str.Size()};
+    auto const [r, size] = DecodeRuneInString<dfa_decoder>(s);
+    if (r != m.r || size != m.str.Size()) {
+      FAIL() << "DecodeRuneInString<dfa_decoder>(" << m.str << ") = " << r
+             << ", " << size << " want " << m.r << ", " << m.str.Size();
+    }
+  }
+
+  // Every first and second byte, followed by the edges of the continuation
+  // ranges or a byte that cannot continue, at every length.
+  constexpr uint8 edges[] = {0x00, 0x7F, 0x80, 0x8F, 0x90,
+                             0x9F, 0xA0, 0xBF, 0xC2, 0xFF};
+  array<uint8, kUTFMax> b;
+  for (int32 b0 = 0; b0 < 256; ++b0) {
+    for (int32 b1 = 0; b1 < 256; ++b1) {
+      for (uint8 const b2 : edges) {
+        for (uint8 const b3 : edges) {
+          b = {uint8(b0), uint8(b1), b2, b3};
+          for (uint64 n = 0; n <= b.size(); ++n) {
+            span<uint8 const> const p{b.data(), n};
+            auto const want = DecodeRune<table_decoder>(p);
+            auto const got = DecodeRune<dfa_decoder>(p);
+            if (got != want) {
+              FAIL() << "DecodeRune<dfa_decoder>(" << std::hex << b0 << " "
+                     << b1 << " " << int32(b2) << " " << int32(b3) << std::dec
+                     << ", " << n << ") = " << got.first << ", "
+                     << int32(got.second) << " want " << want.first << ", "
+                     << int32(want.second);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
 void testSequence(string_view s) {
   struct info {
     int32 index;
@@ -402,6 +526,308 @@ TEST(utf8, TestSequencing) {
   }
 }
 
+static_assert(std::bidirectional_iterator<string_iterator>);
+
+void testIterator(string_view s) {
+  span<uint8 const> const b{s.Data(), s.Size()};
+  uint64 i = 0;
+  string_iterator it = s.begin();
+  for (; it != s.end(); ++it) {
+    auto const [r, size] = DecodeRune(b.subspan(i));
+    if (it.Offset() != i || *it != r || it.Width() != size) {
+      FAIL() << "iterating " << s << ": at " << it.Offset() << " got " << *it
+             << ", " << int32(it.Width()) << " want " << i << ", " << r
+             << ", " << int32(size);
+      return;
+    }
+    i += size;
+  }
+  if (i != s.Size() || it.Width() != 0) {
+    FAIL() << "iterating " << s << " stopped at " << i;
+    return;
+  }
+  while (it != s.begin()) {
+    --it;
+    auto const [r, size] = DecodeLastRune(b.subspan(0, i));
+    i -= size;
+    if (it.Offset() != i || *it != r || it.Width() != size) {
+      FAIL() << "iterating " << s << " back: at " << it.Offset() << " got "
+             << *it << ", " << int32(it.Width()) << " want " << i << ", " << r
+             << ", " << int32(size);
+      return;
+    }
+  }
+  if (i != 0) {
+    FAIL() << "iterating " << s << " back stopped at " << i;
+  }
+}
+
+TEST(utf8, TestStringIterator) {
+  for (string const& ts : testStrings) {
+    testIterator({ts.Data(), ts.Size()});
+    for (string const& is : invalidSequenceTests) {
+      string const s = ts + is + ts;
+      testIterator({s.Data(), s.Size()});
+    }
+  }
+
+  string_literal const s = "a日\xff" "b";
+  slice<rune> runes(s.begin(), s.end());
+  slice<rune> const want = {'a', 0x65E5, kRuneError, 'b'};
+  if (runes != want) {
+    FAIL() << "slice from iterators has " << runes.size() << " runes";
+  }
+  runes.assign(std::make_reverse_iterator(s.end()),
+               std::make_reverse_iterator(s.begin()));
+  std::reverse(runes.begin(), runes.end());
+  if (runes != want) {
+    FAIL() << "slice from reverse iterators has " << runes.size() << " runes";
+  }
+  string_iterator it = s.begin();
+  if (*it++ != 'a' || *it != 0x65E5 || *it-- != 0x65E5 || *it != 'a') {
+    FAIL() << "postfix steps";
+  }
+}
+
+static_assert(sizeof(string) == 24);
+
+bool equalBytes(string const& s, slice<uint8> const& want) {
+  return s.Size() == want.size() &&
+         std::equal(want.begin(), want.end(), s.Data());
+}
+
+TEST(utf8, TestString) {
+  for (uint64 size : {0, 1, 21, 22, 23, 24, 100}) {
+    slice<uint8> want(size);
+    for (uint64 i = 0; i < size; ++i) {
+      want[i] = 'a' + i % 26;
+    }
+    string s{want.data(), size};
+    uint8 const* const self = reinterpret_cast<uint8 const*>(&s);
+    bool const inline_data = s.Data() >= self && s.Data() < self + sizeof(s);
+    if (inline_data != (size <= string::kInlineCapacity)) {
+      FAIL() << "string of " << size << " bytes inline: " << inline_data;
+    }
+    if (!equalBytes(s, want) || s.Data()[size] != '\n') {
+      FAIL() << "string of " << size << " bytes: " << s;
+    }
+
+    string clone = s.Clone();
+    if (!equalBytes(clone, want) || clone.Data() == s.Data()) {
+      FAIL() << "Clone of " << size << " bytes: " << clone;
+    }
+    string moved = std::move(clone);
+    if (!equalBytes(moved, want) || clone.Size() != 0) {
+      FAIL() << "moving " << size << " bytes: " << moved << ", left "
+             << clone.Size();
+    }
+    moved = std::move(s);
+    if (!equalBytes(moved, want) || s.Size() != 0) {
+      FAIL() << "move-assigning " << size << " bytes: " << moved;
+    }
+
+    string sum = moved + moved;
+    slice<uint8> twice = want;
+    twice.insert(twice.end(), want.begin(), want.end());
+    if (!equalBytes(sum, twice)) {
+      FAIL() << "operator+ of " << size << " bytes: " << sum;
+    }
+    if (!equalBytes(string(size, 'x'), slice<uint8>(size, 'x'))) {
+      FAIL() << "string(" << size << ", 'x')";
+    }
+  }
+
+  string const empty;
+  if (empty.Size() != 0 || empty.Data()[0] != '\n') {
+    FAIL() << "default string has " << empty.Size() << " bytes";
+  }
+  string const list{'a', 'b', '\0'};
+  if (!equalBytes(list, {'a', 'b'}) || list.Data()[2] != '\0') {
+    FAIL() << "string from initializer_list: " << list;
+  }
+}
+
+// counting_resource counts the bytes it has out on the default resource.
+class counting_resource : public memory_resource {
+ public:
+  int64 allocated = 0;
+  int64 blocks = 0;
+
+ private:
+  void* do_allocate(uint64 bytes, uint64 alignment) override {
+    allocated += bytes;
+    ++blocks;
+    return std::pmr::get_default_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void* p, uint64 bytes, uint64 alignment) override {
+    allocated -= bytes;
+    std::pmr::get_default_resource()->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(memory_resource const& o) const noexcept override {
+    return this == &o;
+  }
+};
+
+TEST(utf8, TestStringResource) {
+  counting_resource counting;
+  {
+    slice<uint8> const want(100, 'r');
+    string short_string{want.data(), string::kInlineCapacity, &counting};
+    if (counting.blocks != 0) {
+      FAIL() << "short string allocated " << counting.allocated << " bytes";
+    }
+    string s{want.data(), want.size(), &counting};
+    string filled{want.size(), 'r', &counting};
+    if (!equalBytes(s, want) || !equalBytes(filled, want) ||
+        s.Data()[want.size()] != '\n' || counting.blocks != 2) {
+      FAIL() << "string in resource: " << s << ", " << counting.blocks
+             << " blocks";
+    }
+    string moved = std::move(s);
+    moved = s.Clone(&counting);
+    moved = filled.Clone(&counting);
+    string heap = filled.Clone();
+    if (!equalBytes(moved, want) || !equalBytes(heap, want) ||
+        counting.blocks != 3) {
+      FAIL() << "Clone into resource: " << moved << ", " << counting.blocks
+             << " blocks";
+    }
+  }
+  if (counting.allocated != 0) {
+    FAIL() << counting.allocated << " bytes left in resource";
+  }
+
+  pool sizes{&counting};
+  arena a{&sizes};
+  pmr::slice<string> keys{&a};
+  for (int64 i = 0; i < 100; ++i) {
+    keys.emplace_back(uint64(40), uint8('a' + i % 26), &a);
+  }
+  if (keys.back().Size() != 40 || keys.back().Data()[0] != 'a' + 99 % 26) {
+    FAIL() << "pmr::slice of strings ends with " << keys.back();
+  }
+  keys.clear();
+  a.release();
+  sizes.release();
+  if (counting.allocated != 0) {
+    FAIL() << counting.allocated << " bytes left after releasing arena";
+  }
+}
+
+TEST(utf8, TestStringOstream) {
+  string const s{(uint8 const*)"abc\0def", 7};
+  std::ostringstream out;
+  out << s << string_view{s.Data(), 3};
+  if (out.str() != std::string("abc\0defabc", 10)) {
+    FAIL() << "operator<< wrote " << out.str().size() << " bytes";
+  }
+}
+
+TEST(utf8, TestStringBuilder) {
+  string_builder b;
+  slice<uint8> want;
+  for (int64 round = 0; round < 3; ++round) {
+    for (Utf8Map const& m : utf8map) {
+      b.WriteRune(m.r);
+      want.insert(want.end(), m.str.Data(), m.str.Data() + m.str.Size());
+      b.Append({m.str.Data(), m.str.Size()});
+      want.insert(want.end(), m.str.Data(), m.str.Data() + m.str.Size());
+    }
+  }
+  b.WriteRune(0xD800);
+  b.WriteRune(kMaxRune + 1);
+  for (int32 i = 0; i < 2; ++i) {
+    want.insert(want.end(), {0xEF, 0xBF, 0xBD});
+  }
+  string_view const view = b.View();
+  if (b.Size() != want.size() || b.Capacity() < b.Size() ||
+      !std::equal(want.begin(), want.end(), view.Data())) {
+    FAIL() << "builder holds " << view << ", want " << want.size()
+           << " bytes";
+  }
+  uint8 const* const buffer = view.Data();
+  string const s = b.Finish();
+  if (!equalBytes(s, want) || s.Data() != buffer || s.Data()[s.Size()] != '\n') {
+    FAIL() << "Finish returned " << s;
+  }
+  if (b.Size() != 0 || b.Capacity() != 0) {
+    FAIL() << "Finish left " << b.Size() << " of " << b.Capacity() << " bytes";
+  }
+
+  b.Reserve(100);
+  uint64 const capacity = b.Capacity();
+  b.Append({reinterpret_cast<uint8 const*>("short"), 5});
+  string const short_string = b.Finish();
+  if (!equalBytes(short_string, {'s', 'h', 'o', 'r', 't'}) ||
+      b.Capacity() != capacity || capacity < 100) {
+    FAIL() << "short Finish returned " << short_string << ", capacity "
+           << b.Capacity();
+  }
+
+  // Appending the builder to itself reads the old buffer while growing.
+  string_builder doubled;
+  doubled.Append({reinterpret_cast<uint8 const*>("ab"), 2});
+  for (int32 i = 0; i < 8; ++i) {
+    doubled.Append(doubled.View());
+  }
+  std::string want_doubled;
+  for (int32 i = 0; i < 256; ++i) {
+    want_doubled += "ab";
+  }
+  string_view const got_doubled = doubled.View();
+  if (got_doubled.Size() != want_doubled.size() ||
+      !std::equal(want_doubled.begin(), want_doubled.end(),
+                  got_doubled.Data())) {
+    FAIL() << "self append holds " << got_doubled;
+  }
+
+  counting_resource counting;
+  {
+    string_builder in_resource{&counting};
+    for (int32 i = 0; i < 100; ++i) {
+      in_resource.WriteRune(0x65E5);
+    }
+    string const long_string = in_resource.Finish();
+    if (long_string.Size() != 300 || counting.allocated == 0) {
+      FAIL() << "builder in resource: " << long_string.Size() << " bytes, "
+             << counting.allocated << " allocated";
+    }
+  }
+  if (counting.allocated != 0) {
+    FAIL() << counting.allocated << " bytes left in resource";
+  }
+}
+
+struct JoinTest {
+  slice<string_view> parts;
+  string_view sep;
+  string_view out;
+};
+
+TEST(utf8, TestJoin) {
+  auto const sv = [](char const* s) {
+    return string_view{reinterpret_cast<uint8 const*>(s)};
+  };
+  slice<JoinTest> const tests = {
+      {{}, sv(", "), sv("")},
+      {{sv("")}, sv(", "), sv("")},
+      {{sv("a")}, sv(", "), sv("a")},
+      {{sv("a"), sv("b"), sv("c")}, sv(", "), sv("a, b, c")},
+      {{sv("日本"), sv(""), sv("語")}, sv(""), sv("日本語")},
+      {{sv("a much longer fragment"), sv("that is not stored inline")},
+       sv(" / "),
+       sv("a much longer fragment / that is not stored inline")},
+  };
+  for (JoinTest const& tt : tests) {
+    string const s = Join({tt.parts.data(), tt.parts.size()}, tt.sep);
+    if (s.Size() != tt.out.Size() ||
+        !std::equal(s.Data(), s.Data() + s.Size(), tt.out.Data())) {
+      FAIL() << "Join(" << tt.parts.size() << " parts, " << tt.sep
+             << ") = " << s << ", want " << tt.out;
+    }
+  }
+}
+
 rune runtimeDecodeRune(string_view s) {
   auto [r, size] = DecodeRuneInString(std::move(s));
   return r;
@@ -469,6 +895,86 @@ TEST(utf8, TestRuneCount) {
   }
 }
 
+// Check that the vector rune counter matches the scalar loop around invalid
+// and truncated sequences at every offset near block boundaries.
+TEST(utf8, TestRuneCountLong) {
+  for (uint64 size : {31, 32, 63, 64, 65, 127, 128, 200}) {
+    slice<uint8> ascii(size, 'a');
+    for (uint64 pos = 0; pos < size; ++pos) {
+      for (Utf8Map const& m : utf8map) {
+        for (uint64 n = 1; n <= m.str.Size(); ++n) {
+          slice<uint8> b = ascii;
+          b.insert(b.begin() + pos, m.str.Data(), m.str.Data() + n);
+          for (uint64 end : {pos + n, b.size()}) {
+            span<uint8 const> const p{b.data(), end};
+            if (int64 want = scalar::RuneCount(p); RuneCount(p) != want) {
+              FAIL() << "RuneCount(" << m.str << " prefix " << n << " at "
+                     << pos << " of " << end << ") = " << RuneCount(p)
+                     << ", want " << want;
+            }
+          }
+        }
+      }
+      for (string const& str : invalidSequenceTests) {
+        slice<uint8> b = ascii;
+        b.insert(b.begin() + pos, str.Data(), str.Data() + str.Size());
+        span<uint8 const> const p{b.data(), b.size()};
+        if (int64 want = scalar::RuneCount(p); RuneCount(p) != want) {
+          FAIL() << "RuneCount(" << str << " at " << pos << " of " << b.size()
+                 << ") = " << RuneCount(p) << ", want " << want;
+        }
+      }
+    }
+  }
+}
+
+TEST(utf8, TestDecodeRunes) {
+  slice<uint8> b;
+  for (string const& ts : testStrings) {
+    b.insert(b.end(), ts.Data(), ts.Data() + ts.Size());
+  }
+  for (Utf8Map const& m : utf8map) {
+    slice<uint8> run;
+    for (int32 i = 0; i < 16; ++i) {
+      run.insert(run.end(), m.str.Data(), m.str.Data() + m.str.Size());
+    }
+    b.insert(b.end(), run.begin(), run.end());
+    b.insert(b.end(), run.begin(), run.end() - 1);
+  }
+  for (string const& str : invalidSequenceTests) {
+    b.insert(b.end(), str.Data(), str.Data() + str.Size());
+  }
+
+  for (uint64 start = 0; start < 64; ++start) {
+    span<uint8 const> const p =
+        span<uint8 const>{b.data(), b.size()}.subspan(start);
+    slice<rune> want;
+    for (span<uint8 const> q = p; !q.empty();) {
+      auto const [r, size] = DecodeRune(q);
+      want.push_back(r);
+      q.remove_prefix(size);
+    }
+    for (uint64 room : {want.size(), want.size() / 2, uint64{17}}) {
+      slice<rune> out(room);
+      slice<rune> scalar_out(room);
+      auto const got = DecodeRunes(p, {out.data(), out.size()});
+      auto const want_counts =
+          scalar::DecodeRunes(p, {scalar_out.data(), scalar_out.size()});
+      if (got != want_counts || out != scalar_out) {
+        FAIL() << "DecodeRunes(b[" << start << ":], " << room << ") = "
+               << got.first << ", " << got.second << ", want "
+               << want_counts.first << ", " << want_counts.second;
+      }
+      for (uint64 i = 0; i < room; ++i) {
+        if (out[i] != want[i]) {
+          FAIL() << "DecodeRunes(b[" << start << ":])[" << i << "] = "
+                 << out[i] << ", want " << want[i];
+        }
+      }
+    }
+  }
+}
+
 TEST(utf8, TestRuneLen) {
   for (RuneLenTest const& tt : runelentests) {
     if (int8 size = RuneLen(tt.r); size != tt.size) {
@@ -491,6 +997,505 @@ TEST(utf8, TestValid) {
   }
 }
 
+// Check that the vector validators agree with the scalar loop when valid,
+// invalid and truncated sequences sit at every offset around block boundaries.
+TEST(utf8, TestValidLong) {
+  for (uint64 size : {31, 32, 63, 64, 65, 127, 128, 200}) {
+    slice<uint8> ascii(size, 'a');
+    if (!Valid({ascii.data(), ascii.size()})) {
+      FAIL() << "Valid(ascii[" << size << "]) = false, want true";
+    }
+    for (uint64 pos = 0; pos < size; ++pos) {
+      for (Utf8Map const& m : utf8map) {
+        for (uint64 n = 1; n <= m.str.Size(); ++n) {
+          slice<uint8> b = ascii;
+          b.resize(pos);
+          b.insert(b.end(), m.str.Data(), m.str.Data() + n);
+          b.insert(b.end(), ascii.begin(), ascii.begin() + (size - pos));
+          span<uint8 const> const p{b.data(), b.size()};
+          if (bool want = scalar::Valid(p); Valid(p) != want) {
+            FAIL() << "Valid(" << m.str << " prefix " << n << " at " << pos
+                   << " of " << b.size() << ") = " << !want << ", want "
+                   << want;
+          }
+          if (bool want = scalar::Valid(p.subspan(0, pos + n));
+              Valid(p.subspan(0, pos + n)) != want) {
+            FAIL() << "Valid(" << m.str << " prefix " << n << " at end "
+                   << pos << ") = " << !want << ", want " << want;
+          }
+        }
+      }
+      for (string const& str : invalidSequenceTests) {
+        slice<uint8> b = ascii;
+        b.insert(b.begin() + pos, str.Data(), str.Data() + str.Size());
+        if (Valid({b.data(), b.size()})) {
+          FAIL() << "Valid(" << str << " at " << pos << " of " << b.size()
+                 << ") = true, want false";
+        }
+        auto const want = scalar::FirstInvalid({b.data(), b.size()});
+        if (auto const got = FirstInvalid({b.data(), b.size()}); got != want) {
+          FAIL() << "FirstInvalid(" << str << " at " << pos << " of "
+                 << b.size() << ") = " << got.first << ", want "
+                 << want.first;
+        }
+      }
+    }
+  }
+}
+
+TEST(utf8, TestParallel) {
+  string_literal japanese = "日本語日本語日本語日";
+  slice<uint8> text;
+  while (text.size() < 4 * kMinParallelChunk) {
+    text.insert(text.end(), japanese.Data(), japanese.Data() + japanese.Size());
+  }
+  string_literal patches[] = {"", "\xff", "\xe2\x82", "\x80\x80\x80\x80",
+                              "\xf0\x9f\x98\x80"};
+  for (uint64 extra = 0; extra < 3; ++extra) {
+    slice<uint8> base = text;
+    base.resize(text.size() - extra);
+    // With 4 threads the input is cut every size bytes.
+    uint64 const size = (base.size() + 3) / 4;
+    for (string const& patch : patches) {
+      for (uint64 cut = size; cut < base.size(); cut += size) {
+        for (uint64 at = cut - 4; at <= cut + 1; ++at) {
+          slice<uint8> b = base;
+          std::copy(patch.Data(), patch.Data() + patch.Size(), b.begin() + at);
+          span<uint8 const> const p{b.data(), b.size()};
+          if (ValidParallel(p, 4) != Valid(p)) {
+            FAIL() << "ValidParallel(" << patch << " at " << at << " of "
+                   << b.size() << ") = " << !Valid(p);
+          }
+          if (RuneCountParallel(p, 4) != RuneCount(p)) {
+            FAIL() << "RuneCountParallel(" << patch << " at " << at << " of "
+                   << b.size() << ") = " << RuneCountParallel(p, 4)
+                   << ", want " << RuneCount(p);
+          }
+        }
+      }
+    }
+  }
+  if (!ValidParallel({}) || RuneCountParallel({}) != 0) {
+    FAIL() << "ValidParallel or RuneCountParallel failed on empty input";
+  }
+}
+
+// FeedPieces feeds b to a stream_validator in pieces of at most size bytes,
+// starting with a first piece of first bytes.
+bool FeedPieces(slice<uint8> const& b, uint64 first, uint64 size) {
+  stream_validator v;
+  span<uint8 const> p{b.data(), b.size()};
+  uint64 n = first < p.size() ? first : p.size();
+  while (true) {
+    v.Feed(p.subspan(0, n));
+    p.remove_prefix(n);
+    if (p.empty()) {
+      break;
+    }
+    n = size < p.size() ? size : p.size();
+  }
+  return v.Finish();
+}
+
+TEST(utf8, TestStreamValidator) {
+  slice<slice<uint8>> inputs;
+  for (ValidTest const& tt : validTests) {
+    inputs.emplace_back(tt.in.Data(), tt.in.Data() + tt.in.Size());
+  }
+  for (string const& str : invalidSequenceTests) {
+    inputs.emplace_back(str.Data(), str.Data() + str.Size());
+  }
+  slice<uint8> mixed;
+  for (string const& ts : testStrings) {
+    mixed.insert(mixed.end(), ts.Data(), ts.Data() + ts.Size());
+  }
+  inputs.push_back(mixed);
+  for (string const& str : invalidSequenceTests) {
+    slice<uint8> b = mixed;
+    b.insert(b.begin() + b.size() / 2, str.Data(), str.Data() + str.Size());
+    inputs.push_back(b);
+    b = mixed;
+    b.insert(b.end(), str.Data(), str.Data() + str.Size());
+    inputs.push_back(b);
+  }
+
+  for (slice<uint8> const& b : inputs) {
+    bool const want = Valid({b.data(), b.size()});
+    for (uint64 first = 0; first <= b.size(); ++first) {
+      for (uint64 size : {1, 2, 3, 5, 64, 1 << 20}) {
+        if (bool const got = FeedPieces(b, first, size); got != want) {
+          string_view const s{b.data(), b.size()};
+          FAIL() << "stream_validator(" << s << " split at " << first
+                 << " then every " << size << ") = " << got << ", want "
+                 << want;
+        }
+      }
+    }
+  }
+}
+
+TEST(utf8, TestFirstInvalid) {
+  for (FirstInvalidTest const& tt : firstinvalidtests) {
+    auto const [offset, error] = FirstInvalidInString(tt.in);
+    if (offset != tt.offset || error != tt.error) {
+      FAIL() << "FirstInvalidInString(" << tt.in << ") = " << offset << ", "
+             << int32(error) << ", want " << tt.offset << ", "
+             << int32(tt.error);
+    }
+
+    // The same sequence after a long valid prefix goes through the vector
+    // kernels.
+    slice<uint8> b(100, 'a');
+    b.insert(b.end(), tt.in.Data(), tt.in.Data() + tt.in.Size());
+    auto const [long_offset, long_error] = FirstInvalid({b.data(), b.size()});
+    if (long_offset != tt.offset + 100 || long_error != tt.error) {
+      FAIL() << "FirstInvalid(a*100 + " << tt.in << ") = " << long_offset
+             << ", " << int32(long_error) << ", want " << tt.offset + 100
+             << ", " << int32(tt.error);
+    }
+  }
+}
+
+std::ostream& operator<<(std::ostream& out, text_stats const& s) {
+  return out << "{valid " << s.valid << ", first_invalid " << s.first_invalid
+             << ", error " << int32(s.error) << ", ascii " << s.ascii
+             << ", runes " << s.runes << ", utf16_len " << s.utf16_len
+             << ", max_width " << int32(s.max_width) << "}";
+}
+
+struct AnalyzeTest {
+  string_literal in;
+  text_stats want;
+};
+
+array<AnalyzeTest, 7> const analyzetests = {{
+    {"", {true, 0, error_kind::kNone, true, 0, 0, 0}},
+    {"hello", {true, 5, error_kind::kNone, true, 5, 5, 1}},
+    {"日本語", {true, 9, error_kind::kNone, false, 3, 3, 3}},
+    {"a\xF0\x9F\x98\x80", {true, 5, error_kind::kNone, false, 2, 3, 4}},
+    {"aé\xff" "b", {false, 3, error_kind::kBadLeadByte, false, 4, 4, 2}},
+    {"\xE6\x97", {false, 0, error_kind::kTruncated, false, 2, 2, 1}},
+    {"\xed\xa0\x80\xF0\x9F\x98\x80",
+     {false, 0, error_kind::kSurrogate, false, 4, 5, 4}},
+}};
+
+TEST(utf8, TestAnalyze) {
+  for (AnalyzeTest const& tt : analyzetests) {
+    string_view const s{tt.in.Data(), tt.in.Size()};
+    if (text_stats const got = AnalyzeString(s); got != tt.want) {
+      FAIL() << "AnalyzeString(" << tt.in << ") = " << got << ", want "
+             << tt.want;
+    }
+  }
+
+  // Around the block edges of the vector kernels, Analyze agrees with the
+  // scalar loop and with the functions it replaces.
+  for (uint64 size : {31, 63, 64, 65, 128, 200}) {
+    slice<uint8> ascii(size, 'a');
+    for (uint64 pos = 0; pos < size; ++pos) {
+      slice<slice<uint8>> inputs;
+      for (Utf8Map const& m : utf8map) {
+        for (uint64 n = 1; n <= m.str.Size(); ++n) {
+          inputs.push_back(ascii);
+          inputs.back().insert(inputs.back().begin() + pos, m.str.Data(),
+                               m.str.Data() + n);
+        }
+      }
+      for (string const& str : invalidSequenceTests) {
+        inputs.push_back(ascii);
+        inputs.back().insert(inputs.back().begin() + pos, str.Data(),
+                             str.Data() + str.Size());
+      }
+      for (slice<uint8> const& b : inputs) {
+        span<uint8 const> const p{b.data(), b.size()};
+        text_stats const got = Analyze(p);
+        text_stats const want = scalar::Analyze(p);
+        auto const [offset, error] = FirstInvalid(p);
+        if (got != want || got.valid != Valid(p) ||
+            got.runes != RuneCount(p) || got.first_invalid != offset ||
+            got.error != error) {
+          FAIL() << "Analyze(" << string_view{b.data(), b.size()} << ") = "
+                 << got << ", want " << want;
+        }
+      }
+    }
+  }
+}
+
+// The code paths of utf8_simd.hpp, each of which is tested where the CPU
+// supports it, although the library only ever runs the widest one.
+constexpr simd::target kTargets[] = {
+    simd::target::kScalar, simd::target::kSSE42, simd::target::kAVX2};
+
+char const* TargetName(simd::target t) {
+  switch (t) {
+    case simd::target::kScalar:
+      return "scalar";
+    case simd::target::kSSE42:
+      return "sse4.2";
+    case simd::target::kAVX2:
+      return "avx2";
+  }
+  return "?";
+}
+
+TEST(utf8, TestTargets) {
+  for (simd::target const t : kTargets) {
+    if (!simd::Supported(t)) {
+      continue;
+    }
+    char const* const name = TargetName(t);
+    for (ValidTest const& tt : validTests) {
+      if (simd::Valid({tt.in.Data(), tt.in.Size()}, t) != tt.out) {
+        FAIL() << name << " Valid(" << tt.in << ") = " << !tt.out
+               << ", want " << tt.out;
+      }
+    }
+    for (RuneCountTest const& tt : runecounttests) {
+      if (int64 const out = simd::RuneCount({tt.in.Data(), tt.in.Size()}, t);
+          out != tt.out) {
+        FAIL() << name << " RuneCount(" << tt.in << ") = " << out
+               << ", want " << tt.out;
+      }
+    }
+    for (FirstInvalidTest const& tt : firstinvalidtests) {
+      slice<uint8> b(100, 'a');
+      b.insert(b.end(), tt.in.Data(), tt.in.Data() + tt.in.Size());
+      for (uint64 const prefix : {uint64{0}, uint64{100}}) {
+        span<uint8 const> const p =
+            span<uint8 const>{b.data(), b.size()}.subspan(100 - prefix);
+        auto const [offset, error] = simd::FirstInvalid(p, t);
+        if (offset != tt.offset + static_cast<int64>(prefix) ||
+            error != tt.error) {
+          FAIL() << name << " FirstInvalid(a*" << prefix << " + " << tt.in
+                 << ") = " << offset << ", " << int32(error) << ", want "
+                 << tt.offset + prefix << ", " << int32(tt.error);
+        }
+      }
+    }
+    for (AnalyzeTest const& tt : analyzetests) {
+      text_stats const got = simd::Analyze({tt.in.Data(), tt.in.Size()}, t);
+      if (got != tt.want) {
+        FAIL() << name << " Analyze(" << tt.in << ") = " << got << ", want "
+               << tt.want;
+      }
+    }
+    for (Utf8Map const& m : utf8map) {
+      slice<uint8> run;
+      for (int32 i = 0; i < 16; ++i) {
+        run.insert(run.end(), m.str.Data(), m.str.Data() + m.str.Size());
+      }
+      slice<rune> runes(16);
+      auto const decoded =
+          simd::DecodeRunes({run.data(), run.size()}, {runes.data(), 16}, t);
+      if (decoded.first != 16 || decoded.second != int64(run.size()) ||
+          runes != slice<rune>(16, m.r)) {
+        FAIL() << name << " DecodeRunes(16 * " << m.str << ") = "
+               << decoded.first << ", " << decoded.second;
+      }
+      slice<uint8> out(run.size());
+      auto const encoded =
+          simd::EncodeRunes({runes.data(), 16}, {out.data(), out.size()}, t);
+      if (encoded.first != 16 || encoded.second != int64(run.size()) ||
+          out != run || simd::EncodedLen({runes.data(), 16}, t) !=
+                             int64(run.size())) {
+        FAIL() << name << " EncodeRunes(16 * " << m.r << ") = "
+               << encoded.first << ", " << encoded.second;
+      }
+    }
+  }
+}
+
+// Check every code path against the scalar loops on random text made of
+// valid, invalid and truncated sequences and runs of ASCII.
+TEST(utf8, TestTargetsRandom) {
+  slice<slice<uint8>> pieces;
+  for (Utf8Map const& m : utf8map) {
+    for (uint64 n = 1; n <= m.str.Size(); ++n) {
+      pieces.emplace_back(m.str.Data(), m.str.Data() + n);
+    }
+  }
+  for (string const& str : invalidSequenceTests) {
+    pieces.emplace_back(str.Data(), str.Data() + str.Size());
+  }
+  std::mt19937_64 rng{1};
+  for (int32 iter = 0; iter < 2000; ++iter) {
+    // Mostly runs of one kind of sequence, so that the block kernels get to
+    // run.
+    uint64 const kind = iter % pieces.size();
+    slice<uint8> b;
+    uint64 const count = rng() % 64;
+    for (uint64 i = 0; i < count; ++i) {
+      if (rng() % 4 == 0) {
+        b.insert(b.end(), rng() % 48, 'a');
+      }
+      slice<uint8> const& piece =
+          pieces[rng() % 4 == 0 ? rng() % pieces.size() : kind];
+      for (uint64 k = rng() % 20; k > 0; --k) {
+        b.insert(b.end(), piece.begin(), piece.end());
+      }
+    }
+    span<uint8 const> const p{b.data(), b.size()};
+    slice<rune> want_runes(b.size());
+    auto const want_decoded =
+        scalar::DecodeRunes(p, {want_runes.data(), want_runes.size()});
+    want_runes.resize(want_decoded.first);
+    for (uint64 k = rng() % 8; k > 0; --k) {
+      want_runes.push_back(static_cast<rune>(rng()));
+    }
+    span<rune const> const r{want_runes.data(), want_runes.size()};
+    slice<uint8> want_bytes(4 * r.size());
+    auto const want_encoded =
+        scalar::EncodeRunes(r, {want_bytes.data(), want_bytes.size()});
+
+    for (simd::target const t : kTargets) {
+      if (!simd::Supported(t)) {
+        continue;
+      }
+      char const* const name = TargetName(t);
+      if (simd::Valid(p, t) != scalar::Valid(p) ||
+          simd::FirstInvalid(p, t) != scalar::FirstInvalid(p) ||
+          simd::RuneCount(p, t) != scalar::RuneCount(p) ||
+          simd::Analyze(p, t) != scalar::Analyze(p)) {
+        FAIL() << name << " disagrees with scalar on "
+               << string_view{b.data(), b.size()} << ": Analyze = "
+               << simd::Analyze(p, t) << ", want " << scalar::Analyze(p);
+      }
+      uint64 const room = rng() % (b.size() + 1);
+      slice<rune> got_runes(room);
+      slice<rune> scalar_runes(room);
+      auto const got_decoded =
+          simd::DecodeRunes(p, {got_runes.data(), room}, t);
+      if (got_decoded !=
+              scalar::DecodeRunes(p, {scalar_runes.data(), room}) ||
+          !std::equal(scalar_runes.begin(),
+                      scalar_runes.begin() + got_decoded.first,
+                      got_runes.begin())) {
+        FAIL() << name << " DecodeRunes(" << string_view{b.data(), b.size()}
+               << ", " << room << ") disagrees with scalar";
+      }
+      slice<uint8> got_bytes(want_bytes.size());
+      if (simd::EncodeRunes(r, {got_bytes.data(), got_bytes.size()}, t) !=
+              want_encoded ||
+          !std::equal(want_bytes.begin(),
+                      want_bytes.begin() + want_encoded.second,
+                      got_bytes.begin()) ||
+          simd::EncodedLen(r, t) != scalar::EncodedLen(r)) {
+        FAIL() << name << " EncodeRunes of " << r.size()
+               << " runes disagrees with scalar";
+      }
+      uint64 const out_room = rng() % (want_bytes.size() + 1);
+      slice<uint8> scalar_bytes(out_room);
+      auto const got_encoded =
+          simd::EncodeRunes(r, {got_bytes.data(), out_room}, t);
+      if (got_encoded !=
+              scalar::EncodeRunes(r, {scalar_bytes.data(), out_room}) ||
+          !std::equal(scalar_bytes.begin(),
+                      scalar_bytes.begin() + got_encoded.second,
+                      got_bytes.begin())) {
+        FAIL() << name << " EncodeRunes of " << r.size() << " runes into "
+               << out_room << " bytes disagrees with scalar";
+      }
+    }
+  }
+}
+
+struct ToValidUTF8Test {
+  string_literal in;
+  string_literal replacement;
+  string_literal out;
+};
+
+ToValidUTF8Test toValidUTF8Tests[] = {
+    {"", "�", ""},
+    {"abc", "�", "abc"},
+    {"﷝", "�", "﷝"},
+    {"a\xff" "b", "�", "a�b"},
+    {"a\xff" "b�", "X", "aXb�"},
+    {"a☺\xff" "b☺\xC0\xAF" "c☺\xff", "", "a☺b☺c☺"},
+    {"a☺\xff" "b☺\xC0\xAF" "c☺\xff", "日本語", "a☺日本語b☺日本語c☺日本語"},
+    {"\xC0\xAF", "�", "�"},
+    {"\xE0\x80\xAF", "�", "�"},
+    {"\xed\xa0\x80", "abc", "abc"},
+    {"\xed\xbf\xbf", "�", "�"},
+    {"\xF0\x80\x80\xaf", "☺", "☺"},
+    {"\xF8\x80\x80\x80\xAF", "�", "�"},
+    {"\xFC\x80\x80\x80\x80\xAF", "�", "�"},
+    {"\xe2\x82" "a\xe2\x82", "?", "?a?"},
+};
+
+TEST(utf8, TestToValidUTF8) {
+  for (ToValidUTF8Test const& tt : toValidUTF8Tests) {
+    // Also exercise the vector paths with a long valid prefix.
+    for (uint64 prefix : {0, 100}) {
+      slice<uint8> in(prefix, 'a');
+      in.insert(in.end(), tt.in.Data(), tt.in.Data() + tt.in.Size());
+      slice<uint8> want(prefix, 'a');
+      want.insert(want.end(), tt.out.Data(), tt.out.Data() + tt.out.Size());
+      string out;
+      string_view const s{in.data(), in.size()};
+      string_view const got =
+          ToValidUTF8(s, out, {tt.replacement.Data(), tt.replacement.Size()});
+      if (!std::equal(got.Data(), got.Data() + got.Size(), want.begin(),
+                      want.end())) {
+        FAIL() << "ToValidUTF8(" << tt.in << ", " << tt.replacement
+               << ") = " << got << ", want " << tt.out;
+      }
+      if (Valid({in.data(), in.size()}) && got != s) {
+        FAIL() << "ToValidUTF8(" << tt.in << ") copied valid input";
+      }
+    }
+  }
+
+  string_literal in = "a\xff";
+  string out;
+  string_view const got = ToValidUTF8({in.Data(), in.Size()}, out);
+  if (got != string_view{out.Data(), out.Size()} || out.Size() != 4) {
+    FAIL() << "ToValidUTF8(" << in << ") = " << got << ", want a� in out";
+  }
+}
+
+// The decoding tables are usable during constant evaluation.
+constexpr uint8 kConstant[] = {'a', 0xC3, 0xA9, 0xE6, 0x97, 0xA5, 0xF0, 0x9F,
+                               0x98, 0x80};
+static_assert(Valid(kConstant));
+static_assert(RuneCount(kConstant) == 4);
+static_assert(DecodeRune({kConstant + 3, 3}) == pair<rune, int8>{0x65E5, 3});
+static_assert(DecodeLastRune(kConstant) == pair<rune, int8>{0x1F600, 4});
+static_assert(!Valid({kConstant + 1, 1}));
+static_assert(FirstInvalid({kConstant, 8}) ==
+              pair<int64, error_kind>{6, error_kind::kTruncated});
+static_assert(Analyze(kConstant) ==
+              text_stats{true, 10, error_kind::kNone, false, 4, 5, 4});
+
+constexpr checked_literal kASCIILiteral = "hello, world";
+static_assert(kASCIILiteral.Size() == 12);
+static_assert(kASCIILiteral.RuneCount() == 12);
+static_assert(kASCIILiteral.ASCII());
+static_assert(kASCIILiteral.UTF16Len() == 12);
+
+constexpr checked_literal kMixedLiteral = "日本語 \xF0\x9F\x98\x80";
+static_assert(kMixedLiteral.Size() == 14);
+static_assert(kMixedLiteral.RuneCount() == 5);
+static_assert(!kMixedLiteral.ASCII());
+static_assert(kMixedLiteral.UTF16Len() == 6);
+
+constexpr checked_literal kEmptyLiteral = "";
+static_assert(kEmptyLiteral.Size() == 0 && kEmptyLiteral.RuneCount() == 0);
+
+TEST(utf8, TestCheckedLiteral) {
+  string_view const v = kMixedLiteral.View();
+  string_literal const want = "日本語 \xF0\x9F\x98\x80";
+  if (v.Size() != want.Size() ||
+      !std::equal(v.Data(), v.Data() + v.Size(), want.Data())) {
+    FAIL() << "View() = " << v << " want " << want;
+  }
+  if (RuneCountInString(v) != kMixedLiteral.RuneCount()) {
+    FAIL() << "RuneCount() = " << kMixedLiteral.RuneCount() << " want "
+           << RuneCountInString(v);
+  }
+}
+
 TEST(utf8, TestValidRune) {
   for (ValidRuneTest const& tt : validrunetests) {
     if (bool ok = ValidRune(tt.r); ok != tt.ok) {
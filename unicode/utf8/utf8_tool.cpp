@@ -0,0 +1,278 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ */
+
+// utf8_tool runs the library over files mapped into memory and reports its
+// throughput on stderr.
+//
+//   utf8_tool valid FILE...      report whether each file is valid UTF-8
+//   utf8_tool count FILE...      count the runes in each file
+//   utf8_tool sanitize FILE      write FILE with invalid sequences replaced
+//                                by U+FFFD to stdout
+//   utf8_tool to-utf16 FILE      write FILE as UTF-16 to stdout
+//   utf8_tool from-utf16 FILE    write FILE, read as UTF-16, as UTF-8 to
+//                                stdout
+//
+// UTF-16 is in host byte order. valid exits with 1 if a file is invalid; all
+// commands exit with 2 on I/O errors.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "types.hpp"
+#include "unicode/utf16/utf16.hpp"
+#include "unicode/utf8/sink.hpp"
+#include "unicode/utf8/utf8.hpp"
+
+namespace rflx {
+namespace unicode {
+namespace utf8 {
+
+namespace {
+
+constexpr uint64 kOutputSize = uint64{1} << 20;
+
+// mapped_file is a read-only mapping of a whole file.
+class mapped_file {
+ public:
+  mapped_file() = default;
+  mapped_file(mapped_file const&) = delete;
+  mapped_file& operator=(mapped_file const&) = delete;
+  ~mapped_file() {
+    if (size_ > 0) {
+      munmap(data_, size_);
+    }
+  }
+
+  // Open maps path, advising the kernel that it is read once, in order.
+  bool Open(char const* path) {
+    int const fd = open(path, O_RDONLY);
+    if (fd < 0) {
+      std::fprintf(stderr, "%s: %s\n", path, std::strerror(errno));
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      std::fprintf(stderr, "%s: %s\n", path, std::strerror(errno));
+      close(fd);
+      return false;
+    }
+    size_ = st.st_size;
+    if (size_ > 0) {
+      data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data_ == MAP_FAILED) {
+        std::fprintf(stderr, "%s: %s\n", path, std::strerror(errno));
+        size_ = 0;
+        close(fd);
+        return false;
+      }
+      madvise(data_, size_, MADV_SEQUENTIAL);
+    }
+    close(fd);
+    return true;
+  }
+
+  span<uint8 const> Bytes() const {
+    return {static_cast<uint8 const*>(data_), size_};
+  }
+
+ private:
+  void* data_ = nullptr;
+  uint64 size_ = 0;
+};
+
+// WriteError reports the error that stopped out.
+int WriteError(fd_sink const& out) {
+  std::fprintf(stderr, "write: %s\n", std::strerror(out.Error()));
+  return 2;
+}
+
+// Report prints the throughput of one command over bytes of input, and over
+// runes if they were counted.
+void Report(char const* what, uint64 bytes, int64 runes,
+            std::chrono::steady_clock::duration elapsed) {
+  double const s = std::chrono::duration<double>(elapsed).count();
+  double const mb = bytes / 1e6;
+  std::fprintf(stderr, "%s: %lu bytes in %.3f s, %.1f MB/s", what, bytes, s,
+               s > 0 ? mb / s : 0);
+  if (runes >= 0) {
+    std::fprintf(stderr, ", %ld runes, %.1f Mrunes/s", runes,
+                 s > 0 ? runes / 1e6 / s : 0);
+  }
+  std::fprintf(stderr, "\n");
+}
+
+int ValidCommand(int argc, char** argv) {
+  int status = 0;
+  for (int i = 0; i < argc; ++i) {
+    mapped_file f;
+    if (!f.Open(argv[i])) {
+      return 2;
+    }
+    auto const start = std::chrono::steady_clock::now();
+    bool const valid = ValidParallel(f.Bytes());
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    if (valid) {
+      std::printf("%s: valid\n", argv[i]);
+    } else {
+      auto const [offset, err] = FirstInvalid(f.Bytes());
+      std::printf("%s: invalid at byte %ld (error %d)\n", argv[i], offset,
+                  static_cast<int>(err));
+      status = 1;
+    }
+    Report(argv[i], f.Bytes().size(), -1, elapsed);
+  }
+  return status;
+}
+
+int CountCommand(int argc, char** argv) {
+  for (int i = 0; i < argc; ++i) {
+    mapped_file f;
+    if (!f.Open(argv[i])) {
+      return 2;
+    }
+    auto const start = std::chrono::steady_clock::now();
+    int64 const runes = RuneCountParallel(f.Bytes());
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%s: %ld\n", argv[i], runes);
+    Report(argv[i], f.Bytes().size(), runes, elapsed);
+  }
+  return 0;
+}
+
+int SanitizeCommand(char const* path) {
+  mapped_file f;
+  if (!f.Open(path)) {
+    return 2;
+  }
+  auto const start = std::chrono::steady_clock::now();
+  // Valid runs go out straight from the mapping; each run of invalid bytes
+  // becomes one RuneError, as with ToValidUTF8.
+  fd_sink out{STDOUT_FILENO, kOutputSize};
+  span<uint8 const> p = f.Bytes();
+  while (!p.empty()) {
+    auto const [valid, err] = FirstInvalid(p);
+    if (!out.Write(string_view{p.data(), static_cast<uint64>(valid)})) {
+      return WriteError(out);
+    }
+    p.remove_prefix(valid);
+    if (err == error_kind::kNone) {
+      break;
+    }
+    while (!p.empty()) {
+      auto const [r, size] = DecodeRune(p);
+      if (r != kRuneError || size != 1) {
+        break;
+      }
+      p.remove_prefix(1);
+    }
+    if (!out.Write(string_view{kRuneErrorBytes, sizeof(kRuneErrorBytes)})) {
+      return WriteError(out);
+    }
+  }
+  if (!out.Flush()) {
+    return WriteError(out);
+  }
+  Report(path, f.Bytes().size(), -1, std::chrono::steady_clock::now() - start);
+  return 0;
+}
+
+int ToUTF16Command(char const* path) {
+  mapped_file f;
+  if (!f.Open(path)) {
+    return 2;
+  }
+  auto const start = std::chrono::steady_clock::now();
+  // The conversion fills buf, so the sink has no buffer of its own.
+  fd_sink out{STDOUT_FILENO, 0};
+  slice<uint16> buf(kOutputSize / sizeof(uint16));
+  span<uint8 const> p = f.Bytes();
+  while (!p.empty()) {
+    auto const [read, written] = utf16::FromUTF8(p, {buf.data(), buf.size()});
+    if (!out.Write(string_view{reinterpret_cast<uint8 const*>(buf.data()),
+                               written * sizeof(uint16)})) {
+      return WriteError(out);
+    }
+    p.remove_prefix(read);
+  }
+  Report(path, f.Bytes().size(), -1, std::chrono::steady_clock::now() - start);
+  return 0;
+}
+
+int FromUTF16Command(char const* path) {
+  mapped_file f;
+  if (!f.Open(path)) {
+    return 2;
+  }
+  span<uint8 const> const bytes = f.Bytes();
+  if (bytes.size() % sizeof(uint16) != 0) {
+    std::fprintf(stderr, "%s: odd number of bytes\n", path);
+    return 2;
+  }
+  auto const start = std::chrono::steady_clock::now();
+  fd_sink out{STDOUT_FILENO, 0};
+  slice<uint8> buf(kOutputSize);
+  // mmap returns page aligned memory, so the units are aligned.
+  span<uint16 const> s{reinterpret_cast<uint16 const*>(bytes.data()),
+                       bytes.size() / sizeof(uint16)};
+  while (!s.empty()) {
+    auto const [read, written] = utf16::ToUTF8(s, {buf.data(), buf.size()});
+    if (!out.Write(string_view{buf.data(), static_cast<uint64>(written)})) {
+      return WriteError(out);
+    }
+    s.remove_prefix(read);
+  }
+  Report(path, bytes.size(), -1, std::chrono::steady_clock::now() - start);
+  return 0;
+}
+
+int Usage() {
+  std::fprintf(stderr,
+               "usage: utf8_tool valid FILE...\n"
+               "       utf8_tool count FILE...\n"
+               "       utf8_tool sanitize FILE\n"
+               "       utf8_tool to-utf16 FILE\n"
+               "       utf8_tool from-utf16 FILE\n");
+  return 2;
+}
+
+}  // namespace
+
+}  // namespace utf8
+}  // namespace unicode
+}  // namespace rflx
+
+int main(int argc, char** argv) {
+  using namespace rflx::unicode::utf8;
+  if (argc < 3) {
+    return Usage();
+  }
+  char const* const command = argv[1];
+  if (std::strcmp(command, "valid") == 0) {
+    return ValidCommand(argc - 2, argv + 2);
+  }
+  if (std::strcmp(command, "count") == 0) {
+    return CountCommand(argc - 2, argv + 2);
+  }
+  if (argc != 3) {
+    return Usage();
+  }
+  if (std::strcmp(command, "sanitize") == 0) {
+    return SanitizeCommand(argv[2]);
+  }
+  if (std::strcmp(command, "to-utf16") == 0) {
+    return ToUTF16Command(argv[2]);
+  }
+  if (std::strcmp(command, "from-utf16") == 0) {
+    return FromUTF16Command(argv[2]);
+  }
+  return Usage();
+}